@@ -0,0 +1,5 @@
+#pragma once
+
+// Number of calls to the global operator new so far, linking this replaces operator new/delete, so it is kept out of
+// mpc_lib and linked only into the programs that report it
+unsigned long long allocation_count();
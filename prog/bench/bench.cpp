@@ -0,0 +1,62 @@
+#include <mpc/graph.h>
+#include <mpc/naive.h>
+#include <mpc/pflow.h>
+#include <mpc/utils.h>
+#include <alloc.h>
+#include <nlohmann/json.hpp>
+#include <functional>
+#include <limits>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "CLI/App.hpp"
+#include "CLI/Formatter.hpp"
+#include "CLI/Config.hpp"
+
+int greedy_threads = 1;
+
+// Every variant ends with the paths, the time includes the decomposition of the flow
+std::vector<std::pair<std::function<path_cover(Graph&)>, std::string>> variants = {
+	{[](Graph &g){return minflow_reduction_path_recover_faster(*pflowk3(g));}, "pflowk3"},
+	{[](Graph &g){return minflow_reduction_path_recover_faster(*pflowk3_bitset(g));}, "pflowk3_bitset"},
+	{[](Graph &g){return minflow_reduction_path_recover_faster(*pflowk2(g));}, "pflowk2"},
+	{pflowk2_cover, "pflowk2_cover"},
+	{[](Graph &g){return minflow_reduction_path_recover_faster(*greedy_minflow_reduction(g));}, "greedy"},
+	{[](Graph &g){return minflow_reduction_path_recover_faster(*greedy_minflow_reduction_incremental(g, greedy_threads));}, "greedy_incremental"}};
+
+// One json line per (k, variant), best of the repetitions
+int main(int argc, char** args) {
+	int N, M, k_max, repeat, seed;
+	CLI::App app{"Compares the pflow variants and the greedy covers on random_x_chain graphs for k = 1, 2, 4, ..., k_max\nExample usage: ./bench -N 100000 -M 300000 --k_max 128"};
+	app.add_option("-N",N,"number of vertices")->default_val(100000);
+	app.add_option("-M",M,"number of edges")->default_val(300000);
+	app.add_option("--k_max",k_max,"largest width parameter")->default_val(128);
+	app.add_option("--repeat",repeat,"repetitions per variant")->default_val(3);
+	app.add_option("--greedy_threads",greedy_threads,"threads of greedy_incremental")->default_val(1);
+	app.add_option("--seed",seed,"seed to use when generating graphs")->default_val(1337);
+	CLI11_PARSE(app, argc, args);
+
+	for(int k=1; k<=k_max; k*=2) {
+		auto g = random_x_chain(k, N, M, seed);
+		for(auto &[solver, name]:variants) {
+			nlohmann::json j;
+			j["graph"]["n"] = g->n;
+			j["graph"]["m"] = g->count_edges();
+			j["graph"]["K_PARAM"] = k;
+			j["solver"]["name"] = name;
+			stopwatch::time_used best = {std::numeric_limits<long long>::max(), 0, 0};
+			for(int r=0; r<repeat; r++) {
+				stopwatch sw = {};
+				auto allocations = allocation_count();
+				auto cover = solver(*g);
+				auto t = sw.lap();
+				j["solver"]["allocations"] = allocation_count()-allocations;
+				if(t.real < best.real)
+					best = t;
+				j["cover"]["width"] = cover.size();
+			}
+			log_time(best, j["solver"]["time"]);
+			std::cout << j.dump() << std::endl;
+		}
+	}
+}
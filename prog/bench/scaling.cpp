@@ -0,0 +1,68 @@
+#include <mpc/graph.h>
+#include <mpc/naive.h>
+#include <mpc/pflow.h>
+#include <mpc/components.h>
+#include <mpc/reach.h>
+#include <mpc/pool.h>
+#include <mpc/utils.h>
+#include <nlohmann/json.hpp>
+#include <functional>
+#include <limits>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "CLI/App.hpp"
+#include "CLI/Formatter.hpp"
+#include "CLI/Config.hpp"
+
+// The phases that run on the pool, each given as many tasks as the pool has threads
+std::vector<std::pair<std::function<void(Graph&, path_cover&, int)>, std::string>> phases = {
+	{[](Graph &g, path_cover &pc, int t){greedy_minflow_reduction_incremental(g, t);}, "greedy_incremental"},
+	{[](Graph &g, path_cover &pc, int t){components_minflow(g, pflowk2, t, 1024);}, "components"},
+	{[](Graph &g, path_cover &pc, int t){segments_minflow(g, pflowk2, 2*t, t);}, "segments"},
+	{[](Graph &g, path_cover &pc, int t){is_valid_cover(pc, g);}, "is_valid_cover"},
+	{[](Graph &g, path_cover &pc, int t){reachability_idx idx(g, pc);}, "reachability_idx"}};
+
+// One json line per (threads, phase), best of the repetitions
+int main(int argc, char** args) {
+	int N, M, K, C, max_threads, repeat, seed;
+	CLI::App app{"Times the phases that run on the task pool for 1, 2, 4, ..., max_threads threads on C disjoint random_x_chain graphs\nExample usage: ./bench_scaling -N 200000 -M 600000 -K 16 -C 8 --max_threads 8"};
+	app.add_option("-N",N,"number of vertices")->default_val(200000);
+	app.add_option("-M",M,"number of edges")->default_val(600000);
+	app.add_option("-K",K,"width parameter of each chain graph")->default_val(16);
+	app.add_option("-C",C,"number of disjoint graphs (weakly connected components)")->default_val(8);
+	app.add_option("--max_threads",max_threads,"largest pool size")->default_val(8);
+	app.add_option("--repeat",repeat,"repetitions per phase")->default_val(3);
+	app.add_option("--seed",seed,"seed to use when generating graphs")->default_val(1337);
+	CLI11_PARSE(app, argc, args);
+
+	Graph g(N/C*C);
+	for(int c=0; c<C; c++) {
+		auto part = random_x_chain(K, N/C, M/C, seed+c);
+		for(int v=1; v<=part->n; v++)
+			for(auto u:part->edge_out[v])
+				g.add_edge(c*(N/C)+v, c*(N/C)+u);
+	}
+	auto pc = minflow_reduction_path_recover_faster(*pflowk2(g));
+	for(int t=1; t<=max_threads; t*=2) {
+		pool_configure(t);
+		for(auto &[phase, name]:phases) {
+			nlohmann::json j;
+			j["graph"]["n"] = g.n;
+			j["graph"]["m"] = g.count_edges();
+			j["graph"]["components"] = C;
+			j["threads"] = t;
+			j["phase"] = name;
+			stopwatch::time_used best = {std::numeric_limits<long long>::max(), 0, 0};
+			for(int r=0; r<repeat; r++) {
+				stopwatch sw = {};
+				phase(g, pc, t);
+				auto used = sw.lap();
+				if(used.real < best.real)
+					best = used;
+			}
+			log_time(best, j["time"]);
+			std::cout << j.dump() << std::endl;
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#include <mpc/graph.h>
+#include <mpc/naive.h>
+#include <mpc/pflow.h>
+#include <mpc/multilevel.h>
+#include <mpc/preprocessing.h>
+#include <mpc/select.h>
+#include <mpc/utils.h>
+#include <nlohmann/json.hpp>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "CLI/App.hpp"
+#include "CLI/Formatter.hpp"
+#include "CLI/Config.hpp"
+
+// The combinations choose_solver picks from, timed like exp times the solver (preprocessing included)
+std::vector<std::pair<std::function<void(Graph&)>, std::string>> candidates = {
+	{[](Graph &g){pflowk2(g);}, "pflowk2"},
+	{[](Graph &g){pflowk3(g);}, "pflowk3"},
+	{[](Graph &g){pflowk2(*sparsify_dfs_elegant(g));}, "pflowk2 --sparsify_dfs"},
+	{[](Graph &g){
+		auto c1 = contract_tree(g);
+		std::swap(c1->g.edge_in, c1->g.edge_out);
+		auto c2 = contract_tree(c1->g);
+		std::swap(c2->g.edge_in, c2->g.edge_out);
+		pflowk2(c2->g);
+	}, "pflowk2 --contract_graph"},
+	{[](Graph &g){multilevel_minflow(g, pflowk2, 1000);}, "pflowk2 --multilevel 1000"}};
+
+// One json line per (graph, candidate) with the features of the graph, and one with the choice of choose_solver
+int main(int argc, char** args) {
+	int N, seed;
+	CLI::App app{"Times the solver and preprocessing combinations of -s auto on the generators, the data behind the rule table of choose_solver\nExample usage: ./bench_select -N 20000"};
+	app.add_option("-N",N,"number of vertices")->default_val(20000);
+	app.add_option("--seed",seed,"seed to use when generating graphs")->default_val(1337);
+	CLI11_PARSE(app, argc, args);
+
+	std::vector<std::pair<std::unique_ptr<Graph>, std::string>> graphs;
+	for(int r:{3, 6, 20})
+		graphs.push_back({random_dag(N, N*r/2, seed), "random_dag m=" + std::to_string(r/2.0) + "n"});
+	for(int k:{4, 64, 512})
+		graphs.push_back({random_x_chain(k, N, 3*N, seed), "random_x_chain k=" + std::to_string(k)});
+	graphs.push_back({random_x_chain(64, N, 20*N, seed), "random_x_chain k=64 m=20n"});
+	graphs.push_back({random_x_partite(8, N/8, 3*N, seed), "random_x_partite x=8"});
+	int depth = 1;
+	while((2<<depth) <= N)
+		depth++;
+	graphs.push_back({binary_tree(depth, false), "binary_tree"});
+	graphs.push_back({binary_tree(depth, true), "binary_tree reverse"});
+	for(auto &[g, name]:graphs) {
+		nlohmann::json j;
+		auto f = compute_features(*g);
+		j["graph"]["name"] = name;
+		j["features"] = {{"n", f.n}, {"m", f.m}, {"avg_degree", f.avg_degree}, {"max_in", f.max_in}, {"max_out", f.max_out}, {"depth", f.depth}, {"largest_level", f.largest_level}, {"tree_likeness", f.tree_likeness}, {"ms", f.ms}};
+		for(auto &[run, candidate]:candidates) {
+			stopwatch sw = {};
+			run(*g);
+			j["candidate"] = candidate;
+			log_time(sw.lap(), j["time"]);
+			std::cout << j.dump() << std::endl;
+		}
+		auto c = choose_solver(f);
+		j.erase("time");
+		j["candidate"] = "chosen";
+		j["choice"] = {{"solver", c.solver}, {"contract_graph", c.contract_graph}, {"sparsify_dfs", c.sparsify_dfs}, {"multilevel", c.multilevel}, {"rule", c.rule}};
+		std::cout << j.dump() << std::endl;
+	}
+}
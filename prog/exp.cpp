@@ -5,12 +5,21 @@
 #include <mpc/naive.h>
 #include <mpc/graph.h>
 #include <mpc/pflow.h>
+#include <mpc/minlen.h>
+#include <alloc.h>
 #include <mpc/utils.h>
 #include <mpc/transitive.h>
 #include <mpc/preprocessing.h>
+#include <mpc/components.h>
+#include <mpc/multilevel.h>
+#include <mpc/anytime.h>
+#include <mpc/select.h>
+#include <mpc/pool.h>
 #include <fstream>
+#include <sstream>
 #include <iostream>
 #include <vector>
+#include <thread>
 #include <nlohmann/json.hpp>
 #include <signal.h>
 #include <unistd.h>
@@ -26,19 +35,29 @@
 #include "CLI/Validators.hpp"
 
 std::vector<std::pair<std::function<void(Flowgraph<Edge::Minflow>&)>, std::string>> mifsol = {
-	{lemon_ns, "lemon_ns"},
-	{lemon_ns_minlen, "lemon_ns_minlen"}, 
-	{lemon_cs, "lemon_cs"},
-	{lemon_cs_minlen, "lemon_cs_minlen"},
-	{lemon_cc, "lemon_cc"},
-	{lemon_cc_minlen, "lemon_cc_minlen"},
-	{lemon_caps, "lemon_caps"},
-	{lemon_caps_minlen, "lemon_caps_minlen"},
-	{naive_minflow_solve, "naive_minflow_solve"}};
+	{lemon_ns<int>, "lemon_ns"},
+	{lemon_ns_minlen<int>, "lemon_ns_minlen"}, 
+	{lemon_cs<int>, "lemon_cs"},
+	{lemon_cs_minlen<int>, "lemon_cs_minlen"},
+	{lemon_cc<int>, "lemon_cc"},
+	{lemon_cc_minlen<int>, "lemon_cc_minlen"},
+	{lemon_caps<int>, "lemon_caps"},
+	{lemon_caps_minlen<int>, "lemon_caps_minlen"},
+	{naive_minflow_solve<int>, "naive_minflow_solve"}};
+// LEMON solvers of mifsol, run on an explicitly converted network so the conversion is timed separately
+std::vector<std::pair<std::pair<lemon_mcf, bool>, std::string>> lemon_mifsol = {
+	{{lemon_mcf::network_simplex, false}, "lemon_ns"},
+	{{lemon_mcf::network_simplex, true}, "lemon_ns_minlen"},
+	{{lemon_mcf::cost_scaling, false}, "lemon_cs"},
+	{{lemon_mcf::cost_scaling, true}, "lemon_cs_minlen"},
+	{{lemon_mcf::cycle_canceling, false}, "lemon_cc"},
+	{{lemon_mcf::cycle_canceling, true}, "lemon_cc_minlen"},
+	{{lemon_mcf::capacity_scaling, false}, "lemon_caps"},
+	{{lemon_mcf::capacity_scaling, true}, "lemon_caps_minlen"}};
 std::vector<std::pair<std::function<void(Flowgraph<Edge::Maxflow>&)>, std::string>> mafsol =
-	{{lemon_preflow, "lemon_preflow"},
-	{maxflow_solve_edmonds_karp, "maxflow_solve_edmonds_karp"},
-	{maxflow_solve_edmonds_karp_DMOD, "maxflow_solve_edmonds_karp_DMOD"}};
+	{{lemon_preflow<int>, "lemon_preflow"},
+	{maxflow_solve_edmonds_karp<int>, "maxflow_solve_edmonds_karp"},
+	{maxflow_solve_edmonds_karp_DMOD<int>, "maxflow_solve_edmonds_karp_DMOD"}};
 
 void graph_info(nlohmann::json &j, Graph &g) {
 	j["graph"]["n"] = g.n;
@@ -48,12 +67,156 @@ void graph_info(nlohmann::json &j, Graph &g) {
 	j["graph"]["m"] = edges;
 }
 
-void run_one(Graph &g, unsigned int timeout_sec, unsigned long mem_limit_bytes, std::string reduction_s, std::string solver_s, bool sparsify_dfs_f, bool contract_trees, std::string output_path, std::string cover_decomposition, nlohmann::json &j) {
+// Cover in the format of --output_cover, <width> and a line of space separated vertices for each path
+path_cover read_cover(std::string filename, int n) {
+	std::ifstream input(filename);
+	if(!input.good()) {
+		std::cerr << "Failed to open " << filename << " for reading\n";
+		exit(1);
+	}
+	int width;
+	input >> width;
+	std::string line;
+	std::getline(input, line);
+	path_cover pc;
+	while((int) pc.size() < width && std::getline(input, line)) {
+		std::istringstream in(line);
+		pc.push_back({});
+		int v;
+		while(in >> v) {
+			if(v < 1 || v > n) {
+				std::cerr << "Vertex " << v << " of the initial cover is not in the graph\n";
+				exit(1);
+			}
+			pc.back().push_back(v);
+		}
+	}
+	return pc;
+}
+
+void write_cover(std::string filename, path_cover &pc) {
+	std::ofstream out(filename);
+	if(!out.good()) {
+		std::cerr << "Failed to open " << filename << " for writing\n";
+		exit(1);
+	}
+	out << pc.size() << "\n";
+	for(auto &path:pc) {
+		for(auto &u:path) {
+			out << u << " ";
+		}
+		out << "\n";
+	}
+}
+
+typedef std::function<std::unique_ptr<Flowgraph<Edge::Minflow>>(Graph&, topo_order, pflow_stats*)> ordered_solver;
+
+// The order with the fewest nodes visited by the dec path searches of solver on the subgraph induced by the first
+// sample vertices of the DFS order (closed under predecessors)
+topo_order pick_topo_order(Graph &g, int sample, ordered_solver solver, nlohmann::json &j) {
+	auto topo = topological_order(g, topo_order::dfs);
+	topo.resize(std::min(sample, g.n));
+	std::vector<int> id(g.n+1);
+	for(int i=0; i<topo.size(); i++)
+		id[topo[i]] = i+1;
+	Graph sg(topo.size());
+	for(auto v:topo)
+		for(auto u:g.edge_in[v])
+			sg.add_edge(id[u], id[v]);
+	topo_order best = topo_order::dfs;
+	long long best_visited = std::numeric_limits<long long>::max();
+	for(auto &[order, name]:topo_orders) {
+		pflow_stats stats;
+		solver(sg, order, &stats);
+		j[name] = stats.visited;
+		if(stats.visited < best_visited) {
+			best_visited = stats.visited;
+			best = order;
+		}
+	}
+	return best;
+}
+
+// solver_s as a function of the graph, the flow solvers start from reduction_s
+minflow_solver make_solver(std::string solver_s, std::string reduction_s, topo_order order, int adaptive_width) {
+	if(solver_s == "pflowk2")
+		return [order](Graph &g){return pflowk2_ordered(g, order);};
+	if(solver_s == "pflowk3")
+		return [order](Graph &g){return pflowk3_ordered(g, order);};
+	if(solver_s == "pflowk3_bitset")
+		return pflowk3_bitset;
+	if(solver_s == "pflowk2_adaptive")
+		return [adaptive_width](Graph &g){return pflowk2_adaptive(g, adaptive_width);};
+	auto solver1 = std::find_if(mifsol.begin(), mifsol.end(), [&solver_s](auto u){return solver_s == u.second;});
+	auto solver2 = std::find_if(mafsol.begin(), mafsol.end(), [&solver_s](auto u){return solver_s == u.second;});
+	if((solver1 == mifsol.end() && solver2 == mafsol.end()) || (reduction_s != "naive" && reduction_s != "greedy" && reduction_s != "greedy_sparsified" && reduction_s != "greedy_incremental")) {
+		std::cerr << "Solver " << solver_s << " not supported on components, segments, series, multilevel or portfolio" << std::endl;
+		exit(1);
+	}
+	return [solver1, solver2, reduction_s](Graph &g) {
+		std::unique_ptr<Flowgraph<Edge::Minflow>> rg;
+		if(reduction_s == "naive") {
+			rg = naive_minflow_reduction(g);
+		} else if(reduction_s == "greedy") {
+			rg = greedy_minflow_reduction(g);
+		} else if(reduction_s == "greedy_incremental") {
+			rg = greedy_minflow_reduction_incremental(g);
+		} else {
+			rg = greedy_minflow_reduction_sparsified(g);
+		}
+		if(solver1 != mifsol.end()) {
+			solver1->first(*rg);
+		} else {
+			minflow_maxflow_reduction(*rg, solver2->first);
+		}
+		return rg;
+	};
+}
+
+void run_one(Graph &g, unsigned int timeout_sec, unsigned long mem_limit_bytes, std::string reduction_s, std::string solver_s, bool sparsify_dfs_f, bool sparsify_cover_f, bool contract_trees, bool edge_cover, int adaptive_width, std::string initial_cover, std::string topo_order_s, int topo_sample, int components, int components_batch, int segments, int segment_threads, bool series, int series_threads, int greedy_threads, int threads, int multilevel, bool multilevel_pairs, bool anytime, std::string anytime_cover, double anytime_interval, std::string portfolio, std::string output_path, std::string cover_decomposition, nlohmann::json &j) {
 	j["reduction"]["name"] = reduction_s;
 	j["solver"]["name"] = solver_s;
 	j["mem_limit_bytes"] = mem_limit_bytes;
 	j["time_limit_sec"] = timeout_sec;
+	j["edge_cover"] = edge_cover;
 	graph_info(j, g);
+	if(solver_s == "auto") {
+		auto f = compute_features(g);
+		auto c = choose_solver(f);
+		j["solver"]["auto"]["features"] = {{"n", f.n}, {"m", f.m}, {"avg_degree", f.avg_degree}, {"max_in", f.max_in}, {"max_out", f.max_out}, {"depth", f.depth}, {"largest_level", f.largest_level}, {"tree_likeness", f.tree_likeness}, {"ms", f.ms}};
+		// Preprocessing asked for explicitly is kept, multilevel only replaces solving the graph as a whole
+		bool whole = !edge_cover && initial_cover.empty() && components == 0 && segments == 0 && !series && multilevel == 0 && !anytime && topo_order_s != "auto";
+		solver_s = c.solver;
+		contract_trees |= c.contract_graph && initial_cover.empty() && !edge_cover;
+		sparsify_dfs_f |= c.sparsify_dfs && !edge_cover;
+		if(whole)
+			multilevel = c.multilevel;
+		j["solver"]["auto"]["rule"] = c.rule;
+		j["solver"]["auto"]["solver"] = solver_s;
+		j["solver"]["auto"]["contract_graph"] = contract_trees;
+		j["solver"]["auto"]["sparsify_dfs"] = sparsify_dfs_f;
+		j["solver"]["auto"]["multilevel"] = multilevel;
+	}
+	if(!initial_cover.empty() && (edge_cover || contract_trees)) {
+		std::cerr << "initial cover not supported with edge cover or contract tree" << std::endl;
+		exit(1);
+	}
+	if((components > 0) + (segments > 0) + series + (multilevel > 0) + anytime + (solver_s == "portfolio") > 1) {
+		std::cerr << "components, segments, series, multilevel, anytime and portfolio can not be combined" << std::endl;
+		exit(1);
+	}
+	if((components > 0 || segments > 0 || series || multilevel > 0 || anytime || solver_s == "portfolio") && (edge_cover || !initial_cover.empty() || topo_order_s == "auto" || solver_s == "pflowk2_minlen")) {
+		std::cerr << "components, segments, series, multilevel, anytime and portfolio not supported with edge cover, initial cover, topo order auto or pflowk2_minlen" << std::endl;
+		exit(1);
+	}
+	if(topo_order_s != "dfs" && solver_s != "pflowk2" && solver_s != "pflowk3") {
+		std::cerr << "topo order only supported with pflowk2 and pflowk3" << std::endl;
+		exit(1);
+	}
+	if(edge_cover && (sparsify_dfs_f || sparsify_cover_f || contract_trees || cover_decomposition != "pathcover")) {
+		std::cerr << "edge cover only supported with pathcover decomposition and no preprocessing" << std::endl;
+		exit(1);
+	}
 
 	stopwatch sw_c = {sw_child};
 	auto pid = fork();
@@ -64,10 +227,15 @@ void run_one(Graph &g, unsigned int timeout_sec, unsigned long mem_limit_bytes,
 		setrlimit(RLIMIT_AS, &rlm);
 		signal(SIGALRM, [](int signum) {exit(124);});
 		alarm(timeout_sec);
+		// Parts too large for the stacks of the workers get threads of their own
+		pool_configure(threads);
+		j["threads"] = pool_threads();
 		stopwatch sw_s = {sw_self};
 		///////
 		j["preprocess"]["sparsify_dfs"]["enabled"] = sparsify_dfs_f;
+		j["preprocess"]["sparsify_cover"]["enabled"] = sparsify_cover_f;
 		j["preprocess"]["contract_tree"]["enabled"] = contract_trees;
+		j["preprocess"]["series"]["enabled"] = series;
 		if(sparsify_dfs_f) {
 			int cn = g.count_edges();
 			j["preprocess"]["sparsify_dfs"]["before"]["m"] = g.count_edges();
@@ -77,6 +245,18 @@ void run_one(Graph &g, unsigned int timeout_sec, unsigned long mem_limit_bytes,
 			j["preprocess"]["sparsify_dfs"]["after"]["m"] = g.count_edges();
 			j["preprocess"]["sparsify_dfs"]["after"]["m_reduction"] = 1-1.0*g.count_edges()/cn;
 		}
+		if(sparsify_cover_f) {
+			int cn = g.count_edges();
+			j["preprocess"]["sparsify_cover"]["before"]["m"] = cn;
+			stopwatch sparsify_time = {};
+			auto greedy = greedy_minflow_reduction(g);
+			auto greedy_cover = minflow_reduction_path_recover_faster(*greedy);
+			j["preprocess"]["sparsify_cover"]["cover"]["width"] = greedy_cover.size();
+			g = *sparsify_cover(g, greedy_cover);
+			log_time(sparsify_time.total(), j["sparsify_cover"]["time"]);
+			j["preprocess"]["sparsify_cover"]["after"]["m"] = g.count_edges();
+			j["preprocess"]["sparsify_cover"]["after"]["m_reduction"] = 1-1.0*g.count_edges()/cn;
+		}
 		Graph original_g = {1};
 		std::unique_ptr<contract_tree_recovery_data> contracted1;
 		std::unique_ptr<contract_tree_recovery_data> contracted2;
@@ -101,14 +281,139 @@ void run_one(Graph &g, unsigned int timeout_sec, unsigned long mem_limit_bytes,
 		////////
 		auto tot = sw_s.lap();
 		std::unique_ptr<Flowgraph<Edge::Minflow>> rg;
-		if(solver_s == "pflowk2") {
+		auto allocations = allocation_count(); // reduction and solver, including the returned network
+		if(components > 0) {
+			topo_order order = std::find_if(topo_orders.begin(), topo_orders.end(), [&topo_order_s](auto &u){return u.second == topo_order_s;})->first;
+			auto solver = make_solver(solver_s, reduction_s, order, adaptive_width);
+			int parts = 0;
+			sw_s.lap();
+			rg = components_minflow(g, solver, components, components_batch, &parts);
+			auto tot = sw_s.lap();
+			log_time(tot, j["solver"]["time"]);
+			j["solver"]["components"]["threads"] = components;
+			j["solver"]["components"]["batch"] = components_batch;
+			j["solver"]["components"]["parts"] = parts;
+		} else if(segments > 0) {
+			topo_order order = std::find_if(topo_orders.begin(), topo_orders.end(), [&topo_order_s](auto &u){return u.second == topo_order_s;})->first;
+			auto solver = make_solver(solver_s, reduction_s, order, adaptive_width);
+			segment_times times;
+			sw_s.lap();
+			rg = segments_minflow(g, solver, segments, segment_threads, &times);
+			auto tot = sw_s.lap();
+			log_time(tot, j["solver"]["time"]);
+			j["solver"]["segments"]["count"] = times.segment.size();
+			j["solver"]["segments"]["threads"] = segment_threads;
+			j["solver"]["segments"]["segment_ms"] = times.segment;
+			j["solver"]["segments"]["merge_ms"] = times.merge;
+			j["solver"]["segments"]["merged"] = times.merged;
+		} else if(series) {
+			topo_order order = std::find_if(topo_orders.begin(), topo_orders.end(), [&topo_order_s](auto &u){return u.second == topo_order_s;})->first;
+			auto solver = make_solver(solver_s, reduction_s, order, adaptive_width);
+			int pieces = 0;
+			sw_s.lap();
+			auto pc = series_cover(g, solver, series_threads, &pieces);
+			rg = cover_minflow_reduction(g, pc);
+			auto tot = sw_s.lap();
+			log_time(tot, j["solver"]["time"]);
+			j["preprocess"]["series"]["threads"] = series_threads;
+			j["preprocess"]["series"]["cuts"] = pieces-1;
+			j["preprocess"]["series"]["pieces"] = pieces;
+		} else if(multilevel > 0) {
+			topo_order order = std::find_if(topo_orders.begin(), topo_orders.end(), [&topo_order_s](auto &u){return u.second == topo_order_s;})->first;
+			auto solver = make_solver(solver_s, reduction_s, order, adaptive_width);
+			multilevel_stats stats;
+			sw_s.lap();
+			rg = multilevel_minflow(g, solver, multilevel, multilevel_pairs, &stats);
+			auto tot = sw_s.lap();
+			log_time(tot, j["solver"]["time"]);
+			j["solver"]["multilevel"]["coarse_n"] = multilevel;
+			j["solver"]["multilevel"]["pairs"] = multilevel_pairs;
+			j["solver"]["multilevel"]["n"] = stats.n;
+			j["solver"]["multilevel"]["m"] = stats.m;
+			j["solver"]["multilevel"]["width"] = stats.width;
+			j["solver"]["multilevel"]["repaired"] = stats.repaired;
+		} else if(solver_s == "portfolio") {
+			topo_order order = std::find_if(topo_orders.begin(), topo_orders.end(), [&topo_order_s](auto &u){return u.second == topo_order_s;})->first;
+			std::vector<std::pair<minflow_solver, std::string>> solvers;
+			std::istringstream names(portfolio);
+			for(std::string name; std::getline(names, name, ','); )
+				solvers.push_back({make_solver(name, reduction_s, order, adaptive_width), name});
+			portfolio_result result;
+			sw_s.lap();
+			rg = portfolio_minflow(g, solvers, &result);
+			auto tot = sw_s.lap();
+			log_time(tot, j["solver"]["time"]);
+			j["solver"]["portfolio"]["winner"] = result.winner;
+			for(int i=0; i<result.names.size(); i++) {
+				j["solver"]["portfolio"]["solvers"][result.names[i]]["ms"] = result.ms[i];
+				j["solver"]["portfolio"]["solvers"][result.names[i]]["finished"] = result.finished[i];
+			}
+		} else if(anytime) {
+			// Stops at 90% of the time limit, the rest is left for decomposing and writing the cover
+			double budget = 900.0*timeout_sec-sw_s.total().real/1000.0;
+			auto &published = j["solver"]["anytime"]["published"];
+			auto publish = [&published, &anytime_cover](anytime_progress &p, Flowgraph<Edge::Minflow> &fg) {
+				published.push_back({{"ms", p.ms}, {"width", p.width}, {"antichain", p.antichain}});
+				if(anytime_cover.empty())
+					return;
+				Flowgraph<Edge::Minflow> copy(fg);
+				auto cover = minflow_reduction_path_recover_faster(copy);
+				write_cover(anytime_cover+".tmp", cover);
+				rename((anytime_cover+".tmp").c_str(), anytime_cover.c_str());
+			};
+			antichain ac;
+			sw_s.lap();
+			rg = anytime_minflow(g, budget, publish, anytime_interval, &ac);
+			auto tot = sw_s.lap();
+			log_time(tot, j["solver"]["time"]);
+			j["solver"]["anytime"]["budget_ms"] = budget;
+			j["solver"]["anytime"]["interval_ms"] = anytime_interval;
+			j["solver"]["anytime"]["width"] = published.back()["width"];
+			j["solver"]["anytime"]["antichain"] = ac.size();
+			j["solver"]["anytime"]["gap"] = published.back()["width"].get<int>()-(int) ac.size();
+		} else if(solver_s == "pflowk2" || solver_s == "pflowk3") {
+			ordered_solver solver = solver_s == "pflowk2" ? ordered_solver(pflowk2_ordered) : ordered_solver(pflowk3_ordered);
 			sw_s.lap();
-			rg = pflowk2(g);
+			topo_order order = topo_order::dfs;
+			if(topo_order_s == "auto") {
+				order = pick_topo_order(g, topo_sample, solver, j["solver"]["topo_order"]["sample"]);
+				log_time(sw_s.lap(), j["solver"]["topo_order"]["sample"]["time"]);
+			} else {
+				order = std::find_if(topo_orders.begin(), topo_orders.end(), [&topo_order_s](auto &u){return u.second == topo_order_s;})->first;
+			}
+			j["solver"]["topo_order"]["name"] = std::find_if(topo_orders.begin(), topo_orders.end(), [order](auto &u){return u.first == order;})->second;
+			pflow_stats stats;
+			auto ordered = [&solver, order, &stats](Graph &g){return solver(g, order, &stats);};
+			rg = edge_cover ? pflow_edge_cover(g, ordered) : ordered(g);
+			auto tot = sw_s.lap();
+			log_time(tot, j["solver"]["time"]);
+			j["solver"]["stats"]["visited"] = stats.visited;
+			j["solver"]["stats"]["layers"] = stats.layers;
+			j["solver"]["stats"]["max_layers"] = stats.max_layers;
+			j["solver"]["stats"]["merges"] = stats.merges;
+		} else if(solver_s == "pflowk2_adaptive") {
+			j["solver"]["adaptive_width"] = adaptive_width;
+			int fallback_at = -1;
+			sw_s.lap();
+			auto solver = [adaptive_width, &fallback_at](Graph &g){return pflowk2_adaptive(g, adaptive_width, &fallback_at);};
+			rg = edge_cover ? pflow_edge_cover(g, solver) : solver(g);
 			auto tot = sw_s.lap();
 			log_time(tot, j["solver"]["time"]);
-		} else if(solver_s == "pflowk3") {
+			j["solver"]["fallback"] = fallback_at;
+		} else if(solver_s == "pflowk2_minlen") {
+			sw_s.lap();
+			rg = edge_cover ? pflow_edge_cover(g, pflowk2) : pflowk2(g);
+			auto width_t = sw_s.lap();
+			if(!edge_cover)
+				rg = full_minflow_reduction(g, *rg); // pflowk2 keeps only a sparsified subset of the edges
+			minflow_minlen_solve(*rg);
+			auto length_t = sw_s.lap();
+			log_time(width_t, j["solver"]["width"]["time"]);
+			log_time(length_t, j["solver"]["length"]["time"]);
+			log_time({width_t.real+length_t.real, width_t.usr+length_t.usr, width_t.sys+length_t.sys}, j["solver"]["time"]);
+		} else if(solver_s == "pflowk3_bitset") {
 			sw_s.lap();
-			rg = pflowk3(g);
+			rg = edge_cover ? pflow_edge_cover(g, pflowk3_bitset) : pflowk3_bitset(g);
 			auto tot = sw_s.lap();
 			log_time(tot, j["solver"]["time"]);
 		} else {
@@ -119,12 +424,29 @@ void run_one(Graph &g, unsigned int timeout_sec, unsigned long mem_limit_bytes,
 				exit(1);
 			}
 			tot = sw_s.lap();
-			if(reduction_s == "naive") {
+			if(edge_cover) {
+				if(reduction_s == "naive") {
+					rg = naive_minflow_reduction_edges(g);
+				} else if(reduction_s == "greedy") {
+					rg = greedy_minflow_reduction_edges(g);
+				} else {
+					std::cerr << "Unknown edge cover minimum flow reduction" << std::endl;
+					exit(1);
+				}
+			} else if(!initial_cover.empty()) {
+				auto pc = read_cover(initial_cover, g.n);
+				j["reduction"]["initial_cover"]["file"] = initial_cover;
+				j["reduction"]["initial_cover"]["width"] = pc.size();
+				rg = cover_minflow_reduction(g, pc);
+			} else if(reduction_s == "naive") {
 				rg = naive_minflow_reduction(g);
 			} else if(reduction_s == "greedy") {
 				rg = greedy_minflow_reduction(g);
 			} else if(reduction_s == "greedy_sparsified") {
 				rg = greedy_minflow_reduction_sparsified(g);
+			} else if(reduction_s == "greedy_incremental") {
+				j["reduction"]["threads"] = greedy_threads;
+				rg = greedy_minflow_reduction_incremental(g, greedy_threads);
 			} else {
 				std::cerr << "Unknown minimum flow reduction" << std::endl;
 				exit(1);
@@ -135,7 +457,12 @@ void run_one(Graph &g, unsigned int timeout_sec, unsigned long mem_limit_bytes,
 			auto reduction_cover = minflow_reduction_path_recover_faster(fgc);
 			j["reduction"]["cover"]["width"] = reduction_cover.size();
 			sw_s.lap();
-			if(solver1 != mifsol.end()) {
+			auto lemon_solver = std::find_if(lemon_mifsol.begin(), lemon_mifsol.end(), [&solver_s](auto u){return solver_s == u.second;});
+			if(lemon_solver != lemon_mifsol.end()) {
+				auto net = lemon_convert(*rg);
+				log_time(sw_s.lap(), j["solver"]["conversion"]["time"]);
+				lemon_minflow_solve(*net, lemon_solver->first.first, lemon_solver->first.second);
+			} else if(solver1 != mifsol.end()) {
 				solver1->first(*rg);
 			} else {
 				minflow_maxflow_reduction(*rg, solver2->first);
@@ -143,12 +470,13 @@ void run_one(Graph &g, unsigned int timeout_sec, unsigned long mem_limit_bytes,
 			auto tot = sw_s.lap();
 			log_time(tot, j["solver"]["time"]);
 		}
+		j["solver"]["allocations"] = allocation_count()-allocations;
 		if(cover_decomposition == "pathcover") {
 			tot = sw_s.lap();
 			auto cover = minflow_reduction_path_recover_faster(*rg);
 			tot = sw_s.lap();
 			log_time(tot, j["path_recover"]["time"]);
-			assert(is_valid_cover(cover, g));
+			assert(edge_cover ? is_valid_edge_cover(cover, g) : is_valid_cover(cover, g));
 			if(contract_trees) {
 				sw_s.lap();
 				swap(contracted2->g.edge_in, contracted2->g.edge_out);
@@ -170,21 +498,8 @@ void run_one(Graph &g, unsigned int timeout_sec, unsigned long mem_limit_bytes,
 			j["memory"] = mem_peak();
 			j["result"] = "ok";
 			std::cout << j.dump() << std::endl;
-			if(output_path.size() > 0) {
-				std::ofstream out(output_path);
-				if(!out.good()) {
-					std::cerr << "Failed to open " << output_path << " for writing\n";
-					exit(1);
-				}
-				out << cover.size() << "\n";
-				for(auto &path:cover) {
-					for(auto &u:path) {
-						out << u << " ";
-					}
-					out << "\n";
-				}
-				out.close();
-			}
+			if(output_path.size() > 0)
+				write_cover(output_path, cover);
 		} else if(cover_decomposition == "chaincover_naive" || cover_decomposition == "chaincover_dict") {
 			tot = sw_s.lap();
 			chain_cover ccover;
@@ -229,7 +544,9 @@ void run_one(Graph &g, unsigned int timeout_sec, unsigned long mem_limit_bytes,
 			std::cerr << "Unknown cover decomposition: " << cover_decomposition << "\n";
 			exit(1);
 		}
-		exit(0);
+		// Portfolio losers may still run and reach the solver tables, which static destructors would free under them
+		std::cout.flush();
+		_exit(0);
 	} else {
 		int status = 0;
 		waitpid(pid, &status, 0); 
@@ -270,6 +587,11 @@ std::vector<std::string> solvers() {
 	std::vector<std::string> ret;
 	ret.push_back("pflowk2");
 	ret.push_back("pflowk3");
+	ret.push_back("pflowk3_bitset");
+	ret.push_back("pflowk2_adaptive");
+	ret.push_back("pflowk2_minlen");
+	ret.push_back("portfolio");
+	ret.push_back("auto");
 	for(auto &u:mifsol) {
 		ret.push_back(u.second);
 	}
@@ -297,19 +619,58 @@ int main(int argc, char** args) {
 	std::string cover_decomposition = "";
 	int seed = 1337;
 	bool sparsify_dfs_f = false;
+	bool sparsify_cover_f = false;
 	bool get_transitive_reduction = false;
 	bool get_transitive_closure = false;
+	bool edge_cover = false;
+	int adaptive_width = 1000;
+	std::string initial_cover = "";
+	std::string topo_order_s = "";
+	int topo_sample = 10000;
+	int components = 0;
+	int components_batch = 4096;
+	int segments = 0;
+	int segment_threads = 0;
+	bool series = false;
+	int series_threads = 0;
+	int greedy_threads = 0;
+	int threads = 1;
+	int multilevel = 0;
+	bool multilevel_pairs = true;
+	bool anytime = false;
+	std::string anytime_cover = "";
+	double anytime_interval = 100;
+	std::string portfolio = "pflowk2,lemon_cs,lemon_ns";
 	int N, M, K;
 	CLI::App app{"Example usage: ./exp -f random_dag -N 20 -M 25 -s pflowk2 --output_cover out_cover"};
 	app.add_option("-f",filepath,"Either a path to a file, which is of format\n\t<# of nodes> <# of edges>\n\ta line for each edge a->b of the form <a b>\nOR\nrandom_dag (N and M must be provided)\nOR\nrandom_x_chain (N, M, K must be provided)")->required();
 	app.add_option("-m",mem_limit_bytes,"memory limit in MB")->default_val(std::numeric_limits<unsigned long>::max());
 	app.add_option("-t",timeout_sec,"time in sec")->default_val(std::numeric_limits<int>::max());
 	app.add_option("-r",reduction,"reduction to use")
-		->check(CLI::IsMember({"naive", "greedy", "greedy_sparsified"}));
+		->check(CLI::IsMember({"naive", "greedy", "greedy_sparsified", "greedy_incremental"}));
+	app.add_option("--threads",threads,"threads of the task pool shared by the parallel phases, at least the tasks of any phase (0 for the hardware threads)")->default_val(1);
+	app.add_option("--greedy_threads",greedy_threads,"tasks of the greedy_incremental reduction (0 for --threads)")->default_val(0);
 	app.add_option("-s",solver,"solver to use")->required()
 		->check(CLI::IsMember(solvers()));
 	app.add_option("--contract_graph",contract_graph, "contract graph in out tree")->default_val(false);
+	app.add_option("--series",series, "split the graph at the vertices comparable with all others and solve the pieces separately")->default_val(false);
+	app.add_option("--series_threads",series_threads, "tasks solving the series pieces (0 for --threads)")->default_val(0);
 	app.add_option("--sparsify_dfs",sparsify_dfs_f,"sparsify graph beforehand using the dfs sparsification")->default_val(false);
+	app.add_option("--sparsify_cover",sparsify_cover_f,"sparsify graph beforehand keeping only the last in-neighbour on each path of the greedy cover")->default_val(false);
+	app.add_option("--edge_cover",edge_cover,"cover every edge instead of every vertex (naive and greedy reductions)")->default_val(false);
+	app.add_option("--adaptive_width",adaptive_width,"pflowk2_adaptive switches to max flow once the width of the processed prefix exceeds this")->default_val(1000);
+	app.add_option("--topo_order",topo_order_s,"order in which pflowk2 and pflowk3 add the vertices, auto runs every order on a sample and keeps the one visiting the fewest nodes")->check(CLI::IsMember({"dfs", "kahn", "longest_path", "reverse", "auto"}))->default_val("dfs");
+	app.add_option("--topo_sample",topo_sample,"number of vertices of the sample of --topo_order auto")->default_val(10000);
+	app.add_option("--components",components,"solve the weakly connected components on this many threads (0 solves the graph as a whole)")->default_val(0);
+	app.add_option("--components_batch",components_batch,"smaller components are solved together in parts of at least this many vertices")->default_val(4096);
+	app.add_option("--segments",segments,"cut the topological order into this many segments, solve them separately and merge the flows (0 solves the graph as a whole)")->default_val(0);
+	app.add_option("--segment_threads",segment_threads,"tasks solving and merging the segments (0 for --threads)")->default_val(0);
+	app.add_option("--multilevel",multilevel,"coarsen the graph until it has at most this many vertices, solve it and refine level by level (0 solves the graph as a whole)")->default_val(0);
+	app.add_option("--multilevel_pairs",multilevel_pairs,"also merge an edge to a single out-neighbour or from a single in-neighbour, besides chains")->default_val(true);
+	app.add_option("--anytime",anytime,"start from the greedy cover and remove decrementing paths until the cover is minimum or 90% of -t has passed, reporting the gap to the largest antichain found")->default_val(false);
+	app.add_option("--anytime_cover",anytime_cover,"with --anytime, the current cover is written to this path (format of --output_cover) whenever it is published")->default_val("");
+	app.add_option("--anytime_interval",anytime_interval,"with --anytime, milliseconds between published covers")->default_val(100);
+	app.add_option("--portfolio",portfolio,"comma separated solvers raced on separate threads by -s portfolio, the first to finish is kept")->default_val("pflowk2,lemon_cs,lemon_ns");
 	app.add_option("--seed", seed, "seed to use when generating graphs")->default_val(1337);
 	app.add_option("--transitive_reduction", get_transitive_reduction, "Use transitive reduction of the graph")->default_val(false);
 	app.add_option("--transitive_closure", get_transitive_closure, "Use transitive closure of the graph")->default_val(false);
@@ -317,8 +678,15 @@ int main(int argc, char** args) {
 	app.add_option("-M",M,"M parameter for the graph generation");
 	app.add_option("-K",K,"K parameter for the graph generation");
 	app.add_option("--cover_decomposition",cover_decomposition,"pathcover decomposes a path cover, chaincover_naive and dict decompose a chain cover by different methods")->check(CLI::IsMember({"pathcover", "chaincover_naive","chaincover_dict"}))->default_val("pathcover");
+	app.add_option("--initial_cover",initial_cover,"Optionally start the flow solvers from the cover in the given path (format of --output_cover) instead of the reduction, vertices it misses get their own path")->default_val("");
 	app.add_option("--output_cover",output_path,"Optionally print the cover to the given path in format:\n\t<width>\t\none line for each path/chain with space separated nodes")->default_val("");
 	CLI11_PARSE(app, argc, args);
+	int hardware = std::max(1u, std::thread::hardware_concurrency());
+	for(int *t:{&greedy_threads, &segment_threads, &series_threads})
+		if(*t == 0)
+			*t = threads > 0 ? threads : hardware;
+	if(threads > 0) // the tasks of a phase run at the same time, as before the pool
+		threads = std::max({threads, components, segment_threads, series_threads, greedy_threads});
 	if(mem_limit_bytes != std::numeric_limits<unsigned long>::max()) {
 		mem_limit_bytes *= 1024*1024;
 	}
@@ -346,5 +714,5 @@ int main(int argc, char** args) {
 	j["graph"]["name"] = filepath;
 	j["graph"]["N_PARAM"] = N;
 	j["graph"]["M_PARAM"] = M;
-	run_one(*g, timeout_sec, mem_limit_bytes, reduction, solver, sparsify_dfs_f, contract_graph, output_path, cover_decomposition, j);
+	run_one(*g, timeout_sec, mem_limit_bytes, reduction, solver, sparsify_dfs_f, sparsify_cover_f, contract_graph, edge_cover, adaptive_width, initial_cover, topo_order_s, topo_sample, components, components_batch, segments, segment_threads, series, series_threads, greedy_threads, threads, multilevel, multilevel_pairs, anytime, anytime_cover, anytime_interval, portfolio, output_path, cover_decomposition, j);
 }
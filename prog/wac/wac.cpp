@@ -20,20 +20,22 @@
 #include "CLI/Formatter.hpp"
 #include "CLI/Config.hpp"
 
-std::vector<std::pair<std::function<void(Flowgraph<Edge::Minflow>&)>, std::string>> mifsol = {
-	{lemon_ns, "lemon_ns"},
-	{lemon_ns_minlen, "lemon_ns_minlen"}, 
-	{lemon_cs, "lemon_cs"},
-	{lemon_cs_minlen, "lemon_cs_minlen"},
-	{lemon_cc, "lemon_cc"},
-	{lemon_cc_minlen, "lemon_cc_minlen"},
-	{lemon_caps, "lemon_caps"},
-	{lemon_caps_minlen, "lemon_caps_minlen"},
-	{naive_minflow_solve, "naive_minflow_solve"}};
-std::vector<std::pair<std::function<void(Flowgraph<Edge::Maxflow>&)>, std::string>> mafsol =
-	{{lemon_preflow, "lemon_preflow"},
-	{maxflow_solve_edmonds_karp, "maxflow_solve_edmonds_karp"},
-	{maxflow_solve_edmonds_karp_DMOD, "maxflow_solve_edmonds_karp_DMOD"}};
+// Summed weights can exceed 2^31, flows are 64-bit
+typedef long long weight_t;
+std::vector<std::pair<std::function<void(Flowgraph<Edge::Minflow_t<weight_t>>&)>, std::string>> mifsol = {
+	{lemon_ns<weight_t>, "lemon_ns"},
+	{lemon_ns_minlen<weight_t>, "lemon_ns_minlen"}, 
+	{lemon_cs<weight_t>, "lemon_cs"},
+	{lemon_cs_minlen<weight_t>, "lemon_cs_minlen"},
+	{lemon_cc<weight_t>, "lemon_cc"},
+	{lemon_cc_minlen<weight_t>, "lemon_cc_minlen"},
+	{lemon_caps<weight_t>, "lemon_caps"},
+	{lemon_caps_minlen<weight_t>, "lemon_caps_minlen"},
+	{naive_minflow_solve<weight_t>, "naive_minflow_solve"}};
+std::vector<std::pair<std::function<void(Flowgraph<Edge::Maxflow_t<weight_t>>&)>, std::string>> mafsol =
+	{{lemon_preflow<weight_t>, "lemon_preflow"},
+	{maxflow_solve_edmonds_karp<weight_t>, "maxflow_solve_edmonds_karp"},
+	{maxflow_solve_edmonds_karp_DMOD<weight_t>, "maxflow_solve_edmonds_karp_DMOD"}};
 
 
 void graph_info(nlohmann::json &j, Graph &g) {
@@ -44,7 +46,7 @@ void graph_info(nlohmann::json &j, Graph &g) {
 	j["graph"]["m"] = edges;
 }
 
-std::pair<Graph*, std::vector<int>> read_graph2(std::string filename) {
+std::pair<Graph*, std::vector<weight_t>> read_graph2(std::string filename) {
 	std::ifstream input(filename);
 	if(!input.good()) {
 		std::cerr << "Failed to open file: " << filename << "\n";
@@ -53,7 +55,7 @@ std::pair<Graph*, std::vector<int>> read_graph2(std::string filename) {
 	int n, m;
 	input >> n >> m;
 	Graph *g = new Graph(n);
-	std::vector<int> weight(n+1);
+	std::vector<weight_t> weight(n+1);
 	for(int i=1; i<=n; i++) {
 		input >> weight[i];
 	}
@@ -85,6 +87,7 @@ Output format:
 
 Solver names correspond to
 	naive_minflow_solve = Find decrementing paths with dfs
+	pflowk2 = Parameterized solver on the sparsified network of pflowk2 (ignores the reduction)
 Implementations from LEMON graph library:
 	ns = NetworkSimplex
 	cs = CostScaling
@@ -99,17 +102,17 @@ From LEMON documentation:
 	std::string solver;
 	std::string reduction;
 	app.add_option("-f,--file", filepath, "Path to input file")->mandatory();
-	std::string solvers_list = "";
+	std::string solvers_list = "pflowk2";
 	for(auto &u:mifsol) {
 		if(!solvers_list.empty())
 			solvers_list.append(", ");
 		solvers_list.append(u.second);
 	}
 	app.add_option("-s,--solver", solver, "Solver to use {"+solvers_list+"}")->mandatory();
-	app.add_option("-r,--reduction", reduction, "Reduction to use {naive}")->mandatory();
+	app.add_option("-r,--reduction", reduction, "Reduction to use {naive, greedy, greedy_sparsified}")->mandatory();
 	CLI11_PARSE(app, argc, args);
 
-	if(reduction != "naive") {
+	if(reduction != "naive" && reduction != "greedy" && reduction != "greedy_sparsified") {
 		std::cerr << "Unknown reduction: " << reduction << "\n";
 		exit(1);
 	}
@@ -117,14 +120,26 @@ From LEMON documentation:
 	auto solver1 = std::find_if(mifsol.begin(), mifsol.end(), [&solver](auto u){return solver == u.second;});
 	//auto solver2 = std::find_if(mafsol.begin(), mafsol.end(), [&solver_s](auto u){return solver_s == u.second;});
 	//if(solver1 == mifsol.end() && solver2 == mafsol.end()) {
-	if(solver1 == mifsol.end()) {
+	if(solver1 == mifsol.end() && solver != "pflowk2") {
 		std::cerr << "Unknown slover: " << solver << std::endl;
 		exit(1);
 	}
 	auto graph = read_graph2(filepath);
 
-	auto fg = naive_minflow_reduction(*graph.first, [&graph](int i){return graph.second[i];});
-	solver1->first(*fg);
+	auto weight = [&graph](int i){return graph.second[i];};
+	std::unique_ptr<Flowgraph<Edge::Minflow_t<weight_t>>> fg;
+	if(solver == "pflowk2") {
+		fg = pflowk2_weighted<weight_t>(*graph.first, weight);
+	} else {
+		if(reduction == "naive") {
+			fg = naive_minflow_reduction<weight_t>(*graph.first, weight);
+		} else if(reduction == "greedy") {
+			fg = greedy_minflow_reduction<weight_t>(*graph.first, weight);
+		} else {
+			fg = greedy_minflow_reduction_sparsified<weight_t>(*graph.first, weight);
+		}
+		solver1->first(*fg);
+	}
 	auto chain = maxantichain_from_minflow(*fg);
 	std::cout << chain.size() << "\n";
 	for(auto u:chain)
@@ -5,7 +5,7 @@
 #include <mpc/antichain.h>
 
 
-antichain maxantichain_from_minflow(Flowgraph<Edge::Minflow> &mf) {
+template<typename T> antichain maxantichain_from_minflow(Flowgraph<Edge::Minflow_t<T>> &mf) {
 	std::vector<int> visited(mf.n+1);
 	auto v_r = [](int v){return (v+1)/2;}; // fg -> original graph
 	antichain mac;
@@ -46,6 +46,9 @@ antichain maxantichain_from_minflow(Flowgraph<Edge::Minflow> &mf) {
 	return mac;
 }
 
+template antichain maxantichain_from_minflow<int>(Flowgraph<Edge::Minflow_t<int>>&);
+template antichain maxantichain_from_minflow<long long>(Flowgraph<Edge::Minflow_t<long long>>&);
+
 bool is_antichain(antichain &ac, Graph &g) {
 	std::vector<bool> visited(g.n+1), antichain(g.n+1);
 	for(auto u:ac)
@@ -4,5 +4,5 @@
 
 typedef std::vector<int> antichain;
 
-antichain maxantichain_from_minflow(Flowgraph<Edge::Minflow> &minflow);
+template<typename T> antichain maxantichain_from_minflow(Flowgraph<Edge::Minflow_t<T>> &minflow);
 bool is_antichain(antichain &antichain, Graph &g);
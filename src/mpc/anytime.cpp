@@ -0,0 +1,97 @@
+#include "anytime.h"
+#include "decremental.h"
+#include "pflow.h"
+#include "cancel.h"
+#include <chrono>
+#include <algorithm>
+
+// Vertices of one level of a longest path layering are pairwise incomparable
+static antichain largest_level(Graph &g) {
+	auto level = longest_path_levels(g);
+	std::vector<int> count(g.n+1);
+	for(int i=1; i<=g.n; i++)
+		count[level[i]]++;
+	int best = std::max_element(count.begin(), count.end())-count.begin();
+	antichain ret;
+	for(int i=1; i<=g.n; i++)
+		if(level[i] == best)
+			ret.push_back(i);
+	return ret;
+}
+
+std::unique_ptr<Flowgraph<Edge::Minflow>> anytime_minflow(Graph &g, double budget_ms, anytime_callback publish, double interval_ms, antichain *ac) {
+	auto start = std::chrono::steady_clock::now();
+	auto elapsed = [&start]() {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+	};
+	// Only the greedy and the repair run under the deadline, publish (which may decompose the flow) and the antichain
+	// run under the token of the caller
+	cancel_token deadline, *caller = cancel_current;
+	deadline.cancel_after(budget_ms);
+	auto best = largest_level(g);
+	std::unique_ptr<Flowgraph<Edge::Minflow>> fg;
+	try {
+		cancel_scope scope(&deadline);
+		fg = greedy_minflow_reduction_incremental(g);
+	} catch(solver_cancelled &) {
+		// no time for the greedy cover, every vertex is a path of its own
+		path_cover pc;
+		for(int i=1; i<=g.n; i++)
+			pc.push_back({i});
+		fg = cover_minflow_reduction(g, pc);
+	}
+	anytime_progress p;
+	auto report = [&p, &fg, &publish, caller]() {
+		cancel_scope scope(caller);
+		publish(p, *fg);
+	};
+	auto width = [&fg]() {
+		int ret = 0;
+		for(auto &[u,e]:fg->edge_out[fg->source])
+			ret += e->flow;
+		return ret;
+	};
+	p.width = width();
+	p.antichain = best.size();
+	p.optimal = p.width == p.antichain;
+	p.ms = elapsed();
+	report();
+	if(!p.optimal) {
+		minflow_decremental dec(*fg);
+		for(auto &[u,e]:fg->edge_out[fg->source])
+			if(e->flow > 0)
+				dec.touched.push_back(u);
+		double last = p.ms;
+		bool stopped = false;
+		try {
+			cancel_scope scope(&deadline);
+			dec.repair([&](int) {
+				p.width--;
+				if(p.width == p.antichain) {
+					stopped = true;
+					return false;
+				}
+				double now = elapsed();
+				if(now-last >= interval_ms) {
+					p.ms = last = now;
+					report();
+				}
+				return true;
+			});
+		} catch(solver_cancelled &) {
+			// the flow stays valid, with the paths removed before the deadline
+			stopped = true;
+			p.width = width();
+		}
+		if(!stopped) {
+			best = maxantichain_from_minflow(*fg);
+			p.antichain = best.size();
+		}
+		p.optimal = p.width == p.antichain;
+		p.ms = elapsed();
+		report();
+	}
+	if(ac)
+		*ac = best;
+	return fg;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <vector>
+#include "graph.h"
+#include "naive.h"
+#include "antichain.h"
+
+// State of anytime_minflow when a cover is published
+struct anytime_progress {
+	double ms = 0; // since the start
+	int width = 0; // paths of the current flow
+	int antichain = 0; // size of the largest antichain known, a lower bound on the width
+	bool optimal = false;
+};
+typedef std::function<void(anytime_progress&, Flowgraph<Edge::Minflow>&)> anytime_callback;
+
+// Minimum flow of the MPC reduction of g that is usable at any time: starts from the incremental greedy reduction and
+// removes decrementing paths from all path starts (minflow_decremental) until none is left or budget_ms has passed.
+// Both run under a cancel_scope expiring after budget_ms, a greedy that does not finish leaves one path per vertex.
+// publish gets the flow (to be copied before decomposing) after the greedy cover, after improvements at most every
+// interval_ms and at the end, under the cancel token of the caller rather than the deadline. The lower bound is the largest level of a longest path layering until the flow is
+// minimal, then the antichain of the flow. The final antichain is stored in ac
+std::unique_ptr<Flowgraph<Edge::Minflow>> anytime_minflow(Graph &g, double budget_ms, anytime_callback publish, double interval_ms=100, antichain *ac=nullptr);
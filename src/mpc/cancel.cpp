@@ -0,0 +1,24 @@
+#include "cancel.h"
+
+static long long now_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void cancel_token::cancel() {
+	cancelled.store(true, std::memory_order_relaxed);
+}
+
+void cancel_token::cancel_after(double ms) {
+	deadline.store(now_ns()+(long long) (ms*1e6), std::memory_order_relaxed);
+}
+
+bool cancel_token::expired() {
+	return cancelled.load(std::memory_order_relaxed) || now_ns() >= deadline.load(std::memory_order_relaxed);
+}
+
+// An expired token is read again at the next point
+bool cancel_poll() {
+	bool expired = cancel_current->expired();
+	cancel_countdown = expired ? 0 : 4096;
+	return expired;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <limits>
+
+// Stops a solver from another thread or at a deadline. The token is installed on the solving thread with
+// cancel_scope, the solvers call cancel_point() in their hot loops and throw solver_cancelled once it is cancelled
+struct cancel_token {
+	std::atomic<bool> cancelled{false};
+	std::atomic<long long> deadline{std::numeric_limits<long long>::max()}; // steady_clock nanoseconds
+
+	void cancel();
+	// Expires ms from now
+	void cancel_after(double ms);
+	bool expired();
+};
+
+// The result of a cancelled solver. The networks a solver owns are freed by the unwinding, a network passed in by
+// reference (the max-flow solvers, decompositions, repair) is left with a partial flow
+struct solver_cancelled : std::exception {
+	const char* what() const noexcept override {
+		return "solver cancelled";
+	}
+};
+
+inline thread_local cancel_token *cancel_current = nullptr;
+inline thread_local int cancel_countdown = 0;
+
+// Installs token on this thread until the end of the scope, scopes nest and nullptr uninstalls
+struct cancel_scope {
+	cancel_token *prev;
+	cancel_scope(cancel_token *token):prev(cancel_current) {
+		cancel_current = token;
+		cancel_countdown = 0;
+	}
+	~cancel_scope() {
+		cancel_current = prev;
+		cancel_countdown = 0;
+	}
+};
+
+// Reads the token of this thread
+bool cancel_poll();
+
+// True if the token of this thread expired, the token is only read after 4096 units of work (e.g. visited nodes)
+// since the last read. For loops that stop cleanly
+inline bool cancel_requested(int work=1) {
+	return cancel_current && (cancel_countdown -= work) <= 0 && cancel_poll();
+}
+
+// Throws solver_cancelled if the token of this thread expired
+inline void cancel_point(int work=1) {
+	if(cancel_requested(work))
+		throw solver_cancelled();
+}
+
+// Same without skipping reads, for points reached rarely (around a LEMON run that can not be interrupted)
+inline void cancel_point_now() {
+	if(cancel_current && cancel_poll())
+		throw solver_cancelled();
+}
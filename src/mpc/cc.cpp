@@ -3,6 +3,7 @@
 #include <stack>
 #include <mpc/graph.h>
 #include <mpc/naive.h>
+#include <mpc/cancel.h>
 #include <memory>
 
 typedef std::vector<std::vector<int>> chain_cover;
@@ -181,6 +182,7 @@ std::unique_ptr<chain_cover> minflow_reduction_cc_fast(Flowgraph<Edge::Minflow>
 		u.height = src_trie.height;
 
 	for(auto &v:topo) {
+		cancel_point();
 		for(auto &[u,e]:fg.edge_in[v_in(v)]) {
 			if(e->flow == 0)
 				continue;
@@ -226,6 +228,7 @@ std::unique_ptr<chain_cover> minflow_reduction_cc_naive(Flowgraph<Edge::Minflow>
 	std::reverse(topo.begin(), topo.end());
 
 	for(auto &v:topo) {
+		cancel_point();
 		for(auto &[u,e]:fg.edge_in[v_in(v)]) {
 			if(u == fg.source)
 				continue;
@@ -0,0 +1,527 @@
+#include "components.h"
+#include "pflow.h"
+#include "decremental.h"
+#include "cancel.h"
+#include "pool.h"
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <iterator>
+#include <cassert>
+#include <pthread.h>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <string>
+
+static auto v_in = [](int v){return v*2-1;};
+static auto v_out = [](int v){return v*2;};
+
+component_parts split_components(Graph &g, int batch) {
+	component_parts ret;
+	std::vector<int> comp(g.n+1, -1), order;
+	order.reserve(g.n);
+	std::vector<std::vector<int>> groups; // vertices of each part
+	for(int i=1; i<=g.n; i++) {
+		if(comp[i] != -1)
+			continue;
+		if(groups.empty() || groups.back().size() >= batch)
+			groups.push_back({});
+		// BFS over both edge directions
+		int begin = order.size();
+		comp[i] = ret.components++;
+		order.push_back(i);
+		for(int h=begin; h<order.size(); h++) {
+			int s = order[h];
+			for(auto *adj:{&g.edge_out[s], &g.edge_in[s]})
+				for(auto u:*adj)
+					if(comp[u] == -1) {
+						comp[u] = comp[i];
+						order.push_back(u);
+					}
+		}
+		if(order.size()-begin >= batch && !groups.back().empty())
+			groups.push_back({});
+		groups.back().insert(groups.back().end(), order.begin()+begin, order.end());
+	}
+	std::sort(groups.begin(), groups.end(), [](auto &a, auto &b){return a.size() > b.size();});
+	std::vector<int> id(g.n+1);
+	for(auto &vs:groups) {
+		std::sort(vs.begin(), vs.end());
+		auto part = std::make_unique<Graph>(vs.size());
+		for(int i=0; i<vs.size(); i++)
+			id[vs[i]] = i+1;
+		for(int i=0; i<vs.size(); i++)
+			for(auto u:g.edge_out[vs[i]])
+				part->add_edge(i+1, id[u]);
+		ret.parts.push_back(std::move(part));
+		ret.ids.push_back(std::move(vs));
+	}
+	return ret;
+}
+
+// The solvers recurse up to the number of nodes of the network, std::thread gets the default stack only
+static void thread_attr(pthread_attr_t &attr, size_t nodes) {
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, std::max<size_t>(8<<20, 256*nodes));
+}
+
+// Runs f(p) for every part p of sizes[p] vertices on at most threads threads, the next part goes to the first idle
+// one. Parts whose recursion fits the stack of the pool are its tasks, larger ones run on threads of their own sized
+// for the largest part (which take the small parts too once the large ones are done), on the calling thread if none
+// can be started. The first exception (e.g. a cancelled part) stops the rest and is rethrown once all are done
+static void for_parts(const std::vector<int> &sizes, int threads, std::function<void(int)> f) {
+	threads = std::max(1, std::min<int>(threads, sizes.size()));
+	std::vector<int> small, large;
+	size_t nodes = 0;
+	for(int p=0; p<sizes.size(); p++) {
+		if(256*(2*(size_t) sizes[p]+2) <= pool_stack()) {
+			small.push_back(p);
+		} else {
+			large.push_back(p);
+			nodes = std::max<size_t>(nodes, 2*(size_t) sizes[p]+2);
+		}
+	}
+	std::atomic<int> next_small(0), next_large(0);
+	auto drain = [&f, &small, &large, &next_small, &next_large](std::vector<int> &parts, std::atomic<int> &next) {
+		try {
+			for(int i; (i = next.fetch_add(1)) < parts.size(); )
+				f(parts[i]);
+		} catch(...) {
+			next_small = small.size();
+			next_large = large.size();
+			throw;
+		}
+	};
+	if(threads == 1) {
+		drain(large, next_large);
+		drain(small, next_small);
+		return;
+	}
+	std::mutex m;
+	std::exception_ptr error;
+	auto own = [&drain, &small, &large, &next_small, &next_large, &m, &error, token=cancel_current]() {
+		cancel_scope scope(token);
+		try {
+			drain(large, next_large);
+			drain(small, next_small);
+		} catch(...) {
+			std::lock_guard<std::mutex> lock(m);
+			if(!error)
+				error = std::current_exception();
+		}
+	};
+	auto run = [](void *arg)->void* {
+		(*(decltype(own)*) arg)();
+		return nullptr;
+	};
+	pthread_attr_t attr;
+	thread_attr(attr, nodes);
+	std::vector<pthread_t> ts;
+	for(int t=0; t<std::min<int>(threads, large.size()); t++) {
+		pthread_t id;
+		if(pthread_create(&id, &attr, run, &own) != 0)
+			break;
+		ts.push_back(id);
+	}
+	pthread_attr_destroy(&attr);
+	if(ts.empty() && !large.empty())
+		own();
+	try {
+		task_group tasks;
+		for(int t=ts.size(); t<threads && t-ts.size()<small.size(); t++)
+			tasks.run([&drain, &small, &next_small]{drain(small, next_small);});
+		tasks.wait();
+	} catch(...) {
+		std::lock_guard<std::mutex> lock(m);
+		if(!error)
+			error = std::current_exception();
+	}
+	for(auto &t:ts)
+		pthread_join(t, nullptr);
+	if(error)
+		std::rethrow_exception(error);
+}
+
+static void for_parts(std::vector<std::unique_ptr<Graph>> &parts, int threads, std::function<void(int)> f) {
+	std::vector<int> sizes;
+	for(auto &g:parts)
+		sizes.push_back(g->n);
+	for_parts(sizes, threads, f);
+}
+
+// Adds the flow pf of the subgraph with vertices ids to fg, a network of the whole graph
+static void add_flow(Flowgraph<Edge::Minflow> &fg, Flowgraph<Edge::Minflow> &pf, std::vector<int> &ids) {
+	assert(pf.n == 2*ids.size()+2);
+	auto map = [&pf, &fg, &ids](int x) {
+		if(x == pf.source)
+			return fg.source;
+		if(x == pf.sink)
+			return fg.sink;
+		int v = ids[(x+1)/2-1];
+		return x%2 ? v_in(v) : v_out(v);
+	};
+	for(int x=1; x<=pf.n; x++) {
+		for(auto &[u,e]:pf.edge_out[x]) {
+			auto *e2 = fg.add_edge(map(x), map(u));
+			e2->demand = e->demand;
+			e2->flow = e->flow;
+		}
+	}
+}
+
+std::unique_ptr<Flowgraph<Edge::Minflow>> components_minflow(Graph &g, minflow_solver solver, int threads, int batch, int *parts) {
+	auto cp = split_components(g, batch);
+	if(parts)
+		*parts = cp.parts.size();
+	std::vector<std::unique_ptr<Flowgraph<Edge::Minflow>>> flows(cp.parts.size());
+	for_parts(cp.parts, threads, [&cp, &flows, &solver](int p) {
+		flows[p] = solver(*cp.parts[p]);
+	});
+	auto fgo = std::make_unique<Flowgraph<Edge::Minflow>>(g.n*2+2, g.n*2+1, g.n*2+2);
+	for(int p=0; p<cp.parts.size(); p++) {
+		add_flow(*fgo, *flows[p], cp.ids[p]);
+		flows[p].reset();
+	}
+	return fgo;
+}
+
+path_cover components_cover(Graph &g, minflow_solver solver, int threads, int batch) {
+	auto cp = split_components(g, batch);
+	std::vector<path_cover> covers(cp.parts.size());
+	for_parts(cp.parts, threads, [&cp, &covers, &solver](int p) {
+		covers[p] = minflow_reduction_path_recover_faster(*solver(*cp.parts[p]));
+		for(auto &path:covers[p])
+			for(auto &u:path)
+				u = cp.ids[p][u-1];
+	});
+	path_cover cover;
+	for(auto &c:covers)
+		std::move(c.begin(), c.end(), std::back_inserter(cover));
+	return cover;
+}
+
+antichain components_antichain(Graph &g, minflow_solver solver, int threads, int batch) {
+	auto cp = split_components(g, batch);
+	std::vector<antichain> acs(cp.parts.size());
+	for_parts(cp.parts, threads, [&cp, &acs, &solver](int p) {
+		acs[p] = maxantichain_from_minflow(*solver(*cp.parts[p]));
+		for(auto &u:acs[p])
+			u = cp.ids[p][u-1];
+	});
+	antichain ac;
+	for(auto &a:acs)
+		ac.insert(ac.end(), a.begin(), a.end());
+	return ac;
+}
+
+// Turns the minimum flow a into the one of a followed by b, two consecutive pieces of a topological order (vertices
+// ids_a and ids_b) with minimum flows. The adjacency of b is moved to a, its edges stay in the storage of b.
+// block and pos give the piece of a vertex and its index in it. The edges from a to b have no flow, so a decrementing
+// path of the union can only go back over them: it starts at a path start of b and ends at a path end of a
+static void merge_segments(Graph &g, std::vector<int> &ids_a, Flowgraph<Edge::Minflow> &a, std::vector<int> &ids_b, Flowgraph<Edge::Minflow> &b, std::vector<int> &block, std::vector<int> &pos, int &merged) {
+	int na = ids_a.size(), n = na+ids_b.size();
+	const int source = 2*n+1, sink = 2*n+2;
+	a.edge_in.resize(2*n+3);
+	a.edge_out.resize(2*n+3);
+	// The old source and sink of a are nodes of b now
+	for(auto &[u,e]:a.edge_out[a.source])
+		for(auto &x:a.edge_in[u])
+			if(x.second == e)
+				x.first = source;
+	for(auto &[u,e]:a.edge_in[a.sink])
+		for(auto &x:a.edge_out[u])
+			if(x.second == e)
+				x.first = sink;
+	std::swap(a.edge_out[source], a.edge_out[a.source]);
+	std::swap(a.edge_in[sink], a.edge_in[a.sink]);
+	auto map = [&b, source, sink, na](int x) {
+		if(x == b.source)
+			return source;
+		if(x == b.sink)
+			return sink;
+		return x+2*na;
+	};
+	for(int x=1; x<=2*ids_b.size(); x++) {
+		a.edge_out[map(x)] = std::move(b.edge_out[x]);
+		a.edge_in[map(x)] = std::move(b.edge_in[x]);
+		for(auto &u:a.edge_out[map(x)])
+			u.first = map(u.first);
+		for(auto &u:a.edge_in[map(x)])
+			u.first = map(u.first);
+	}
+	for(auto &[u,e]:b.edge_out[b.source])
+		a.edge_out[source].push_back({map(u), e});
+	for(auto &[u,e]:b.edge_in[b.sink])
+		a.edge_in[sink].push_back({map(u), e});
+	a.n = 2*n+2;
+	a.source = source;
+	a.sink = sink;
+	const int bb = block[ids_b[0]];
+	for(int i=0; i<na; i++)
+		for(auto u:g.edge_out[ids_a[i]])
+			if(block[u] == bb)
+				a.add_edge(v_out(i+1), v_in(na+pos[u]+1));
+	minflow_decremental dec(a);
+	for(auto &[u,e]:a.edge_out[a.source])
+		if(e->flow > 0 && u > 2*na)
+			dec.touched.push_back(u);
+	merged += dec.repair();
+}
+
+std::unique_ptr<Flowgraph<Edge::Minflow>> segments_minflow(Graph &g, minflow_solver solver, int segments, int threads, segment_times *times) {
+	segments = std::max(1, std::min(segments, g.n));
+	auto topo = topological_order(g, topo_order::dfs);
+	std::vector<int> seg(g.n+1), id(g.n+1);
+	std::vector<std::vector<int>> ids(segments);
+	for(int i=0; i<g.n; i++) {
+		int v = topo[i];
+		seg[v] = (long long) i*segments/g.n;
+		ids[seg[v]].push_back(v);
+		id[v] = ids[seg[v]].size();
+	}
+	std::vector<std::unique_ptr<Graph>> parts;
+	for(int p=0; p<segments; p++) {
+		parts.push_back(std::make_unique<Graph>(ids[p].size()));
+		for(auto v:ids[p])
+			for(auto u:g.edge_out[v])
+				if(seg[u] == p)
+					parts[p]->add_edge(id[v], id[u]);
+	}
+	std::vector<std::unique_ptr<Flowgraph<Edge::Minflow>>> flows(segments);
+	std::vector<double> ms(segments);
+	for_parts(parts, threads, [&parts, &flows, &ms, &solver](int p) {
+		auto start = std::chrono::steady_clock::now();
+		flows[p] = solver(*parts[p]);
+		ms[p] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+	});
+	// Neighbouring segments are merged pairwise, every round halves their number
+	auto start = std::chrono::steady_clock::now();
+	// The merged pieces keep the network of their first segment, the other networks hold edges until the end
+	std::vector<int> block(g.n+1), pos(g.n+1), merged(segments), net(segments);
+	std::iota(net.begin(), net.end(), 0);
+	while(ids.size() > 1) {
+		for(int p=0; p<ids.size(); p++) {
+			for(int i=0; i<ids[p].size(); i++) {
+				block[ids[p][i]] = p;
+				pos[ids[p][i]] = i;
+			}
+		}
+		std::vector<int> sizes; // of the merged pieces
+		for(int p=0; p+1<ids.size(); p+=2)
+			sizes.push_back(ids[p].size()+ids[p+1].size());
+		for_parts(sizes, threads, [&g, &ids, &flows, &net, &block, &pos, &merged](int p) {
+			merge_segments(g, ids[2*p], *flows[net[2*p]], ids[2*p+1], *flows[net[2*p+1]], block, pos, merged[p]);
+			ids[2*p].insert(ids[2*p].end(), ids[2*p+1].begin(), ids[2*p+1].end());
+		});
+		std::vector<std::vector<int>> next_ids;
+		std::vector<int> next_net;
+		for(int p=0; p<ids.size(); p+=2) {
+			next_ids.push_back(std::move(ids[p]));
+			next_net.push_back(net[p]);
+		}
+		ids = std::move(next_ids);
+		net = std::move(next_net);
+	}
+	auto fgo = std::make_unique<Flowgraph<Edge::Minflow>>(g.n*2+2, g.n*2+1, g.n*2+2);
+	add_flow(*fgo, *flows[net[0]], ids[0]);
+	if(times) {
+		times->segment = ms;
+		times->merge = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+		times->merged = std::accumulate(merged.begin(), merged.end(), 0);
+	}
+	return fgo;
+}
+
+// Series cuts of g in the topological order topo. pos(x) < i reaches the vertex at i iff it has an out-neighbour at a
+// position <= i (following these ends at i), and symmetrically for pos(x) > i
+static std::vector<int> series_cuts(Graph &g, std::vector<int> &topo, std::vector<int> &pos) {
+	auto big = std::numeric_limits<int>::max();
+	std::vector<int> after(g.n, big), cuts; // after[i] is the smallest max in-neighbour position of pos > i
+	for(int i=g.n-2; i>=0; i--) {
+		int maxin = -1;
+		for(auto u:g.edge_in[topo[i+1]])
+			maxin = std::max(maxin, pos[u]);
+		after[i] = std::min(after[i+1], maxin);
+	}
+	int before = -1; // largest min out-neighbour position of pos < i
+	for(int i=0; i<g.n; i++) {
+		int v = topo[i];
+		if(before <= i && after[i] >= i)
+			cuts.push_back(v);
+		int minout = big;
+		for(auto u:g.edge_out[v])
+			minout = std::min(minout, pos[u]);
+		before = std::max(before, minout);
+	}
+	return cuts;
+}
+
+std::vector<int> series_cuts(Graph &g) {
+	auto topo = topological_order(g, topo_order::dfs);
+	std::vector<int> pos(g.n+1);
+	for(int i=0; i<g.n; i++)
+		pos[topo[i]] = i;
+	return series_cuts(g, topo, pos);
+}
+
+path_cover series_cover(Graph &g, minflow_solver solver, int threads, int *pieces) {
+	auto topo = topological_order(g, topo_order::dfs);
+	std::vector<int> pos(g.n+1);
+	for(int i=0; i<g.n; i++)
+		pos[topo[i]] = i;
+	auto cuts = series_cuts(g, topo, pos);
+	std::vector<int> piece(g.n+1, -1); // piece of a vertex, -1 for the cuts
+	std::vector<std::vector<int>> ids(cuts.size()+1);
+	for(int i=0, p=0; i<g.n; i++) {
+		int v = topo[i];
+		if(p < cuts.size() && v == cuts[p]) {
+			p++;
+			continue;
+		}
+		piece[v] = p;
+		ids[p].push_back(v);
+	}
+	std::vector<std::unique_ptr<Graph>> parts;
+	std::vector<int> id(g.n+1);
+	for(int p=0; p<ids.size(); p++) {
+		parts.push_back(std::make_unique<Graph>(ids[p].size()));
+		for(int i=0; i<ids[p].size(); i++)
+			id[ids[p][i]] = i+1;
+		for(auto v:ids[p])
+			for(auto u:g.edge_out[v])
+				if(piece[u] == p)
+					parts[p]->add_edge(id[v], id[u]);
+	}
+	std::vector<path_cover> covers(parts.size());
+	for_parts(parts, threads, [&parts, &covers, &ids, &solver](int p) {
+		if(parts[p]->n == 0)
+			return;
+		covers[p] = minflow_reduction_path_recover_faster(*solver(*parts[p]));
+		for(auto &path:covers[p])
+			for(auto &u:path)
+				u = ids[p][u-1];
+	});
+	if(pieces)
+		*pieces = parts.size();
+	int width = g.n ? 1 : 0;
+	for(auto &c:covers)
+		width = std::max<int>(width, c.size());
+	// The out-neighbour at the smallest position leads to the next cut, the in-neighbour at the largest back to the
+	// previous one
+	std::vector<int> next(g.n+1), prev(g.n+1);
+	for(int v=1; v<=g.n; v++) {
+		for(auto u:g.edge_out[v])
+			if(!next[v] || pos[u] < pos[next[v]])
+				next[v] = u;
+		for(auto u:g.edge_in[v])
+			if(!prev[v] || pos[u] > pos[prev[v]])
+				prev[v] = u;
+	}
+	path_cover cover(width);
+	for(int j=0; j<width; j++) {
+		auto &path = cover[j];
+		for(int p=0; p<=cuts.size(); p++) {
+			if(j < covers[p].size()) {
+				auto &q = covers[p][j];
+				if(!path.empty()) {
+					int start = path.size();
+					for(int x=q[0]; x != path[start-1]; x=prev[x])
+						path.push_back(x);
+					std::reverse(path.begin()+start, path.end());
+					path.pop_back(); // q[0]
+				}
+				path.insert(path.end(), q.begin(), q.end());
+			}
+			if(p == cuts.size())
+				break;
+			if(path.empty())
+				path.push_back(cuts[p]);
+			while(path.back() != cuts[p])
+				path.push_back(next[path.back()]);
+		}
+	}
+	return cover;
+}
+
+// Shared by portfolio_minflow and its threads, the last one to finish frees it. ms[i] is -1 until solver i finishes
+struct portfolio_state {
+	Graph g;
+	std::mutex m;
+	std::condition_variable done;
+	cancel_token losers; // cancelled once there is a winner
+	std::unique_ptr<Flowgraph<Edge::Minflow>> flow;
+	int winner = -1;
+	int failed = 0; // solvers that threw something else than solver_cancelled, error is the first of them
+	std::exception_ptr error;
+	std::vector<double> ms;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	portfolio_state(Graph &g, int solvers):g(g),ms(solvers, -1) {
+	}
+};
+
+std::unique_ptr<Flowgraph<Edge::Minflow>> portfolio_minflow(Graph &g, std::vector<std::pair<minflow_solver, std::string>> &solvers, portfolio_result *result) {
+	assert(!solvers.empty());
+	auto state = std::make_shared<portfolio_state>(g, solvers.size());
+	pthread_attr_t attr;
+	thread_attr(attr, g.n*2+2);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	auto run = [](void *arg)->void* {
+		auto f = (std::function<void()>*) arg;
+		(*f)();
+		delete f;
+		return nullptr;
+	};
+	for(int i=0; i<solvers.size(); i++) {
+		auto *f = new std::function<void()>([state, solver=solvers[i].first, i]() {
+			std::unique_ptr<Flowgraph<Edge::Minflow>> flow;
+			try {
+				cancel_scope scope(&state->losers);
+				flow = solver(state->g);
+			} catch(solver_cancelled &) {
+				return;
+			} catch(...) { // e.g. bad_alloc of a loser under a memory limit, must not leave the detached thread
+				std::lock_guard<std::mutex> lock(state->m);
+				if(!state->error)
+					state->error = std::current_exception();
+				state->failed++;
+				state->done.notify_one();
+				return;
+			}
+			std::lock_guard<std::mutex> lock(state->m);
+			state->ms[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-state->start).count();
+			if(state->winner == -1) {
+				state->winner = i;
+				state->flow = std::move(flow);
+				state->losers.cancel();
+				state->done.notify_one();
+			}
+		});
+		pthread_t t;
+		if(pthread_create(&t, &attr, run, f) != 0)
+			run(f); // no thread left for this solver, race it from here
+	}
+	pthread_attr_destroy(&attr);
+	std::unique_lock<std::mutex> lock(state->m);
+	int n = solvers.size();
+	while(!state->done.wait_for(lock, std::chrono::milliseconds(1), [&state, n]{return state->winner != -1 || state->failed == n;})) {
+		if(cancel_current && cancel_poll()) {
+			state->losers.cancel();
+			throw solver_cancelled();
+		}
+	}
+	if(state->winner == -1) // every solver failed
+		std::rethrow_exception(state->error);
+	if(result) {
+		*result = {};
+		result->winner = solvers[state->winner].second;
+		for(int i=0; i<solvers.size(); i++) {
+			result->names.push_back(solvers[i].second);
+			result->finished.push_back(state->ms[i] >= 0);
+			result->ms.push_back(state->ms[i] >= 0 ? state->ms[i] : state->ms[state->winner]);
+		}
+	}
+	return std::move(state->flow);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "graph.h"
+#include "naive.h"
+#include "antichain.h"
+
+typedef std::function<std::unique_ptr<Flowgraph<Edge::Minflow>>(Graph&)> minflow_solver;
+
+// Weakly connected components of g grouped into parts of at least batch vertices (a larger component is a part of
+// its own). ids[p][i] is the vertex of g numbered i+1 in parts[p], parts are sorted by decreasing size
+struct component_parts {
+	int components = 0;
+	std::vector<std::unique_ptr<Graph>> parts;
+	std::vector<std::vector<int>> ids;
+};
+component_parts split_components(Graph &g, int batch);
+
+// The parts are solved by solver as threads tasks of the pool (pool.h), biggest part first. Parts whose recursion
+// needs more stack than the workers have run on threads of their own sized for them. No edge joins two parts, so the
+// minimum flows and their covers and antichains are unions
+std::unique_ptr<Flowgraph<Edge::Minflow>> components_minflow(Graph &g, minflow_solver solver, int threads, int batch=4096, int *parts=nullptr);
+// Cover and antichain of every part are also computed on its thread, the ids are those of g
+path_cover components_cover(Graph &g, minflow_solver solver, int threads, int batch=4096);
+antichain components_antichain(Graph &g, minflow_solver solver, int threads, int batch=4096);
+
+// Milliseconds spent on each segment and on the merge of segments_minflow, merged is the number of paths it removed
+struct segment_times {
+	std::vector<double> segment;
+	double merge = 0;
+	int merged = 0;
+};
+// Cuts a topological order of g into segments pieces of equal size and solves their induced subgraphs by solver on
+// threads threads. Neighbouring pieces are then merged pairwise (also on threads) by adding the edges between them
+// and searching decrementing paths from the path starts of the later piece. Each of the O(k) searches may span both
+// pieces, so a merge takes O(k(n+m)) on the merged pieces
+std::unique_ptr<Flowgraph<Edge::Minflow>> segments_minflow(Graph &g, minflow_solver solver, int segments, int threads, segment_times *times=nullptr);
+
+// Vertices comparable with every other vertex, in topological order, O(n+m)
+std::vector<int> series_cuts(Graph &g);
+// MPC of g from the pieces between consecutive series cuts solved by solver on threads threads. An antichain lies in
+// one piece, so the width is the largest width of a piece (at least 1). The i-th paths of the pieces are joined
+// through the cuts
+path_cover series_cover(Graph &g, minflow_solver solver, int threads, int *pieces=nullptr);
+
+// Outcome of portfolio_minflow, ms[i] is the time solver i ran until it finished (finished[i]) or the winner finished
+struct portfolio_result {
+	std::string winner;
+	std::vector<std::string> names;
+	std::vector<double> ms;
+	std::vector<bool> finished;
+};
+// Races the solvers on detached threads over one shared copy of g and returns the flow of the first to finish. The
+// others are cancelled (cancel.h) and stop at their next cancel point, a LEMON solver only once its run returns, so
+// they do not use the pool. Cancelling the caller cancels all of them. A solver that throws anything else drops out,
+// once all of them did the first exception is rethrown
+std::unique_ptr<Flowgraph<Edge::Minflow>> portfolio_minflow(Graph &g, std::vector<std::pair<minflow_solver, std::string>> &solvers, portfolio_result *result=nullptr);
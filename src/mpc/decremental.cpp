@@ -0,0 +1,188 @@
+#include "decremental.h"
+#include "naive.h"
+#include "cancel.h"
+#include <vector>
+#include <algorithm>
+
+static auto v_in = [](int v){return v*2-1;};
+static auto v_out = [](int v){return v*2;};
+
+minflow_decremental::minflow_decremental(Flowgraph<Edge::Minflow> &fg):fg(fg),parent_b(fg.n+1, {0, nullptr}),parent_f(fg.n+1, {0, nullptr}),pos(fg.n+1, -1),dead_b(fg.n+1),dead_f(fg.n+1) {
+	assert(is_valid_minflow(fg));
+}
+
+// source->x and x->sink, added if the reduction did not have them
+static Edge::Minflow* source_edge(Flowgraph<Edge::Minflow> &fg, int x) {
+	for(auto &[u,e]:fg.edge_in[x])
+		if(u == fg.source)
+			return e;
+	return fg.add_edge(fg.source, x);
+}
+
+static Edge::Minflow* sink_edge(Flowgraph<Edge::Minflow> &fg, int x) {
+	for(auto &[u,e]:fg.edge_out[x])
+		if(u == fg.sink)
+			return e;
+	return fg.add_edge(x, fg.sink);
+}
+
+void minflow_decremental::delete_edge(int a, int b) {
+	auto *e = fg.find_edge(v_out(a), v_in(b));
+	int flow = e->flow;
+	fg.delete_edge(v_out(a), v_in(b));
+	if(flow == 0)
+		return;
+	sink_edge(fg, v_out(a))->flow += flow;
+	source_edge(fg, v_in(b))->flow += flow;
+	touched.push_back(v_out(a));
+	touched.push_back(v_in(b));
+}
+
+// The source and sink edges of v stay with flow 0 (removing them would scan all source and sink edges)
+void minflow_decremental::delete_vertex(int v) {
+	auto is_source = [this](std::pair<int, Edge::Minflow*> x) {return x.first==fg.source;};
+	auto is_sink = [this](std::pair<int, Edge::Minflow*> x) {return x.first==fg.sink;};
+	for(auto &[u,e]:fg.edge_in[v_in(v)]) {
+		if(u == fg.source) {
+			e->flow = 0;
+			continue;
+		}
+		if(e->flow > 0) {
+			sink_edge(fg, u)->flow += e->flow;
+			touched.push_back(u);
+		}
+		auto is_e = [e=e](std::pair<int, Edge::Minflow*> x) {return x.second==e;};
+		fg.edge_out[u].erase(std::find_if(fg.edge_out[u].begin(), fg.edge_out[u].end(), is_e));
+	}
+	for(auto &[u,e]:fg.edge_out[v_out(v)]) {
+		if(u == fg.sink) {
+			e->flow = 0;
+			continue;
+		}
+		if(e->flow > 0) {
+			source_edge(fg, u)->flow += e->flow;
+			touched.push_back(u);
+		}
+		auto is_e = [e=e](std::pair<int, Edge::Minflow*> x) {return x.second==e;};
+		fg.edge_in[u].erase(std::find_if(fg.edge_in[u].begin(), fg.edge_in[u].end(), is_e));
+	}
+	auto &in = fg.edge_in[v_in(v)];
+	in.erase(std::remove_if(in.begin(), in.end(), [&is_source](auto x){return !is_source(x);}), in.end());
+	auto &out = fg.edge_out[v_out(v)];
+	out.erase(std::remove_if(out.begin(), out.end(), [&is_sink](auto x){return !is_sink(x);}), out.end());
+	fg.edge_out[v_in(v)].clear();
+	fg.edge_in[v_out(v)].clear();
+}
+
+// BFS over the residual from root towards the sink (forward) or from the source (backward), returns the node next
+// to the sink/source or 0. parent[x] = {+y, e} if e lowers its flow and {-y, e} if e raises it, y is the next node
+// towards root. Nodes with dead[x] are known not to reach the sink/source and are skipped
+static int residual_search(Flowgraph<Edge::Minflow> &fg, int root, bool forward, std::vector<std::pair<int, Edge::Minflow*>> &parent, std::vector<int> &queue, std::vector<bool> &dead) {
+	queue.clear();
+	queue.push_back(root);
+	parent[root] = {root, nullptr};
+	auto visit = [&fg, &parent, &queue, &dead](int s, int u, Edge::Minflow *e, bool lower) {
+		if(u == fg.source || u == fg.sink || parent[u].first || dead[u])
+			return;
+		parent[u] = {lower ? s : -s, e};
+		queue.push_back(u);
+	};
+	for(int h=0; h<queue.size(); h++) {
+		int s = queue[h];
+		for(auto &[u,e]:fg.edge_out[s]) {
+			if(forward && u == fg.sink && e->flow > e->demand)
+				return s;
+			if(!forward || e->flow > e->demand)
+				visit(s, u, e, forward);
+		}
+		for(auto &[u,e]:fg.edge_in[s]) {
+			if(!forward && u == fg.source && e->flow > e->demand)
+				return s;
+			if(forward || e->flow > e->demand)
+				visit(s, u, e, !forward);
+		}
+	}
+	return 0;
+}
+
+// Before the deletions there was no decrementing path, so a new one goes through a node whose source or sink edge
+// got flow. Removing a path only adds residual edges along it, so its nodes are checked again. Every touched node
+// is checked until it is on no decrementing path, which leaves none.
+// A node that can not reach the sink (or be reached from the source) could only do so through the removed path,
+// whose nodes already could, so failed searches are not repeated: the failed searches of one call explore every node
+// at most once per direction in total. Only those are memoized, each successful search may explore the whole network
+// again, so a call removing p paths takes O((p+1)(n+m)) on the network
+int minflow_decremental::repair(const std::function<bool(int)> &after_path) {
+	int removed = 0;
+	std::vector<int> dead_reset;
+	auto search = [this, &dead_reset](int c, bool forward)->int {
+		auto &parent = forward ? parent_f : parent_b;
+		auto &queue = forward ? queue_f : queue_b;
+		auto &dead = forward ? dead_f : dead_b;
+		int x = residual_search(fg, c, forward, parent, queue, dead);
+		if(!x) {
+			for(auto u:queue) {
+				dead[u] = true;
+				dead_reset.push_back(u);
+			}
+		}
+		return x;
+	};
+	bool stop = false, cancelled = false;
+	while(!touched.empty() && !stop) {
+		if((cancelled = cancel_current && cancel_poll())) // a search can take long, the token is read every time
+			break;
+		int c = touched.back();
+		int x = dead_b[c] || dead_f[c] ? 0 : search(c, false);
+		int y = x ? search(c, true) : 0;
+		if(x && y) {
+			// source->x..c..y->sink, cut at the first node of x..c that is also on c..y to get a simple path
+			for(int cur = y, i = 0; ; cur = abs(parent_f[cur].first)) {
+				pos[cur] = i++;
+				if(cur == c)
+					break;
+			}
+			int z = x;
+			while(pos[z] == -1)
+				z = abs(parent_b[z].first);
+			for(int cur = y; ; cur = abs(parent_f[cur].first)) {
+				pos[cur] = -1;
+				if(cur == c)
+					break;
+			}
+			source_edge(fg, x)->flow--;
+			sink_edge(fg, y)->flow--;
+			for(int cur = x; cur != z; ) {
+				auto [p, e] = parent_b[cur];
+				e->flow += p > 0 ? -1 : 1;
+				touched.push_back(cur);
+				cur = abs(p);
+			}
+			for(int cur = y; cur != z; ) {
+				auto [p, e] = parent_f[cur];
+				e->flow += p > 0 ? -1 : 1;
+				touched.push_back(cur);
+				cur = abs(p);
+			}
+			touched.push_back(z);
+			removed++;
+			stop = after_path && !after_path(removed);
+		} else {
+			touched.pop_back();
+		}
+		for(auto u:queue_b)
+			parent_b[u] = {0, nullptr};
+		for(auto u:queue_f)
+			parent_f[u] = {0, nullptr};
+		queue_b.clear();
+		queue_f.clear();
+	}
+	for(auto u:dead_reset) {
+		dead_b[u] = false;
+		dead_f[u] = false;
+	}
+	assert(is_valid_minflow(fg));
+	if(cancelled)
+		throw solver_cancelled();
+	return removed;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "graph.h"
+#include <functional>
+
+// Keeps a minimum flow of the MPC reduction minimal under edge and vertex deletions. The network must have
+// v_out(a)->v_in(b) for every edge (a,b) of the graph, e.g. the naive/greedy reductions or full_minflow_reduction
+// of pflowk2 (pflowk2 alone drops edges that a deletion could make necessary).
+// Deletions move the flow of removed edges to new path ends (to the sink, from the source), repair() then only
+// searches decrementing paths through the nodes these ends touch. A deleted vertex stays in the network without edges
+struct minflow_decremental {
+	Flowgraph<Edge::Minflow> &fg;
+	std::vector<int> touched; // nodes that can be on a decrementing path
+	// Scratch of the searches towards the source (b) and the sink (f)
+	std::vector<std::pair<int, Edge::Minflow*>> parent_b, parent_f;
+	std::vector<int> queue_b, queue_f, pos;
+	std::vector<bool> dead_b, dead_f;
+
+	minflow_decremental(Flowgraph<Edge::Minflow> &fg);
+	void delete_edge(int a, int b);
+	void delete_vertex(int v);
+	// Restores minimality after any number of deletions in O((p+1)(n+m)) on the network, returns the number p of paths
+	// removed. after_path is called with the number removed so far after each path, returning false stops early with
+	// a valid flow. A cancelled repair (cancel.h) also leaves a valid flow and can be resumed
+	int repair(const std::function<bool(int)> &after_path=nullptr);
+};
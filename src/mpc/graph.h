@@ -7,6 +7,7 @@
 #include <memory>
 #include <iostream>
 #include <deque>
+#include <cassert>
 
 struct Graph {
 
@@ -68,15 +69,19 @@ struct Graph {
 
 };
 
+// Flow values are templated, unweighted MPC flows are bounded by n and use int, weighted inputs (e.g. wac)
+// can sum past 2^31 and use long long
 namespace Edge {
-	struct Minflow {
-		int flow = 0;
-		int demand = 0;
+	template<typename T> struct Minflow_t {
+		T flow = 0;
+		T demand = 0;
 	};
-	struct Maxflow {
-		int flow = 0;
-		int capacity = 0;
+	template<typename T> struct Maxflow_t {
+		T flow = 0;
+		T capacity = 0;
 	};
+	typedef Minflow_t<int> Minflow;
+	typedef Maxflow_t<int> Maxflow;
 	struct Maxflow_skew : Maxflow {
 		int flow = 0;
 		int capacity = 0;
@@ -128,13 +133,15 @@ template<typename EdgeT> struct Flowgraph {
 		return std::find_if(edge_out[a].begin(), edge_out[a].end(), is_b)->second;
 	}
 
+	// The edge itself stays in edges (deque storage), only its adjacency entries are removed
 	void delete_edge(int a, int b) {
 		auto is_b = [&b](std::pair<int, EdgeT*> x) {return x.first==b;};
 		auto e1 = std::find_if(edge_out[a].begin(), edge_out[a].end(), is_b);
-		delete e1->second;
+		assert(e1 != edge_out[a].end());
+		EdgeT *e = e1->second;
 		edge_out[a].erase(e1);
-		auto is_a = [&a](std::pair<int, EdgeT*> x) {return x.first==a;};
-		edge_in[b].erase(std::find_if(edge_in[b].begin(), edge_in[b].end(), is_a));
+		auto is_e = [e](std::pair<int, EdgeT*> x) {return x.second==e;};
+		edge_in[b].erase(std::find_if(edge_in[b].begin(), edge_in[b].end(), is_e));
 	}
 
 	~Flowgraph() {
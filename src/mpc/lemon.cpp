@@ -1,7 +1,8 @@
 #include "graph.h"
 #include "lemon.h"
+#include "cancel.h"
 #include <algorithm>
-#include <lemon/list_graph.h>
+#include <lemon/static_graph.h>
 #include <lemon/concepts/digraph.h>
 #include <lemon/edmonds_karp.h>
 #include <lemon/preflow.h>
@@ -19,171 +20,159 @@
 
 using namespace lemon;
 
-// Preflow
-void lemon_preflow(Flowgraph<Edge::Maxflow> &input_graph) {
-	ListDigraph g;
-	std::vector<ListDigraph::Node> v;
+// Builds the StaticDigraph in one pass, node i of input_graph is node i-1 and arc k has edge v_e[k]. Arcs are in
+// the order of edge_out so they are sorted by source as StaticDigraph::build requires, the optional extra arc
+// (extra_from->extra_to) is placed after the arcs of extra_from and has no edge
+template<typename EdgeT> void lemon_build(StaticDigraph &g, Flowgraph<EdgeT> &input_graph, std::vector<EdgeT*> &v_e, int extra_from=0, int extra_to=0) {
+	std::vector<std::pair<int,int>> arcs;
 	for(int i=1; i<=input_graph.n; i++) {
-		v.push_back(g.addNode());
-	}
-	std::vector<std::pair<ListDigraph::Arc, Edge::Maxflow*>> v_e;
-
-	for(int i=1; i<input_graph.n; i++) {
 		for(auto &[u,e]:input_graph.edge_out[i]) {
-			v_e.push_back({g.addArc(v[i-1], v[u-1]), e});
+			arcs.push_back({i-1, u-1});
+			v_e.push_back(e);
+		}
+		if(i == extra_from) {
+			arcs.push_back({extra_from-1, extra_to-1});
+			v_e.push_back(nullptr);
 		}
 	}
+	g.build(input_graph.n, arcs.begin(), arcs.end());
+}
 
-	auto cap = ListDigraph::ArcMap<int>(g);
-	for(auto &[a,e]:v_e) {
-		cap[a] = e->capacity;
+// Preflow
+template<typename T> void lemon_preflow(Flowgraph<Edge::Maxflow_t<T>> &input_graph) {
+	StaticDigraph g;
+	std::vector<Edge::Maxflow_t<T>*> v_e;
+	lemon_build(g, input_graph, v_e);
+
+	StaticDigraph::ArcMap<T> cap(g);
+	for(int k=0; k<v_e.size(); k++) {
+		cap[g.arc(k)] = v_e[k]->capacity;
 	}
 
-	Preflow<ListDigraph> ek(g, cap, v[input_graph.source-1], v[input_graph.sink-1]);
+	Preflow<StaticDigraph, StaticDigraph::ArcMap<T>> ek(g, cap, g.node(input_graph.source-1), g.node(input_graph.sink-1));
+	cancel_point_now();
 	ek.run();
-	for(auto &[a,e]:v_e) {
-		e->flow = ek.flow(a);
+	cancel_point_now();
+	for(int k=0; k<v_e.size(); k++) {
+		v_e[k]->flow = ek.flow(g.arc(k));
 	}
 }
 
-struct lemon_minflow {
-	std::unique_ptr<ListDigraph::ArcMap<int>> demand, cost;
-	ListDigraph::Node source, sink;
-	std::vector<std::pair<ListDigraph::Arc, Edge::Minflow*>> v_e;
-	ListDigraph g;
-
-	lemon_minflow(Flowgraph<Edge::Minflow> &input_graph, bool mincost) {
-		std::vector<ListDigraph::Node> v;
-		for(int i=1; i<=input_graph.n; i++) {
-			v.push_back(g.addNode());
-		}
-		for(int i=1; i<input_graph.n; i++) {
-			for(auto &[u,e]:input_graph.edge_out[i]) {
-				v_e.push_back({g.addArc(v[i-1], v[u-1]), e});
-			}
-		}
-		demand = std::make_unique<ListDigraph::ArcMap<int>>(g);
-		cost = std::make_unique<ListDigraph::ArcMap<int>>(g);
-
-		source = v[input_graph.source-1];
-		sink = v[input_graph.sink-1];
-		auto ea = g.addArc(v[input_graph.source-1], v[input_graph.sink-1]);
-		(*cost)[ea] = 0;
-		for(auto &[a,e]:v_e) {
-			(*demand)[a] = e->demand;
-			if(mincost) {
-				if(g.source(a) == v[input_graph.source-1]) {
-					(*cost)[a] = input_graph.n;
-				} else {
-					(*cost)[a] = 1;
-				}
+// Costs use the flow type as well, the total cost is bounded by n times the flow value
+template<typename T> struct lemon_network {
+	StaticDigraph g;
+	std::vector<Edge::Minflow_t<T>*> v_e;
+	std::unique_ptr<StaticDigraph::ArcMap<T>> demand, cost_width, cost_length;
+	StaticDigraph::Node source, sink;
+	T supply; // upper bound for the flow, e.g. edge covers may need more than n paths
+
+	lemon_network(Flowgraph<Edge::Minflow_t<T>> &input_graph) {
+		lemon_build(g, input_graph, v_e, input_graph.source, input_graph.sink);
+		demand = std::make_unique<StaticDigraph::ArcMap<T>>(g, 0);
+		cost_width = std::make_unique<StaticDigraph::ArcMap<T>>(g, 0);
+		cost_length = std::make_unique<StaticDigraph::ArcMap<T>>(g, 0);
+
+		source = g.node(input_graph.source-1);
+		sink = g.node(input_graph.sink-1);
+		supply = 0;
+		for(auto &[u,e]:input_graph.edge_out[input_graph.source])
+			supply += e->flow;
+		supply = std::max(supply, T(input_graph.n));
+		for(int k=0; k<v_e.size(); k++) {
+			if(!v_e[k]) // source->sink
+				continue;
+			auto a = g.arc(k);
+			(*demand)[a] = v_e[k]->demand;
+			if(g.source(a) == source) {
+				(*cost_width)[a] = 1;
+				(*cost_length)[a] = input_graph.n;
 			} else {
-				if(g.source(a) == v[input_graph.source-1]) {
-					(*cost)[a] = 1;
-				} else {
-					(*cost)[a] = 0;
-				}
+				(*cost_length)[a] = 1;
 			}
 		}
 	}
+
+	// The run itself can not be cancelled, a token that expired during it is noticed before the flow is copied back
+	template<typename Solver> void run(Solver &s, bool minlen) {
+		s.stSupply(source, sink, supply);
+		s.lowerMap(*demand);
+		s.costMap(minlen ? *cost_length : *cost_width);
+		cancel_point_now();
+		s.run();
+		cancel_point_now();
+		for(int k=0; k<v_e.size(); k++)
+			if(v_e[k])
+				v_e[k]->flow = s.flow(g.arc(k));
+	}
 };
 
-// NetworkSimplex
-void lemon_ns(Flowgraph<Edge::Minflow> &input_graph) {
-	auto mf = lemon_minflow(input_graph, false);
-	NetworkSimplex<ListDigraph> ns(mf.g);
-	ns.stSupply(mf.source, mf.sink, input_graph.n);
-	ns.lowerMap(*mf.demand);
-	ns.costMap(*mf.cost);
-	ns.run();
-	for(auto &[a,e]:mf.v_e) {
-		e->flow = ns.flow(a);
+template<typename T> std::shared_ptr<lemon_network<T>> lemon_convert(Flowgraph<Edge::Minflow_t<T>> &input_graph) {
+	return std::make_shared<lemon_network<T>>(input_graph);
+}
+
+template<typename T> void lemon_minflow_solve(lemon_network<T> &net, lemon_mcf algorithm, bool minlen) {
+	if(algorithm == lemon_mcf::network_simplex) {
+		NetworkSimplex<StaticDigraph, T, T> ns(net.g);
+		net.run(ns, minlen);
+	} else if(algorithm == lemon_mcf::cost_scaling) {
+		CostScaling<StaticDigraph, T, T> cs(net.g);
+		net.run(cs, minlen);
+	} else if(algorithm == lemon_mcf::cycle_canceling) {
+		CycleCanceling<StaticDigraph, T, T> cc(net.g);
+		net.run(cc, minlen);
+	} else {
+		CapacityScaling<StaticDigraph, T, T> cs(net.g);
+		net.run(cs, minlen);
 	}
 }
 
+// NetworkSimplex
+template<typename T> void lemon_ns(Flowgraph<Edge::Minflow_t<T>> &input_graph) {
+	lemon_minflow_solve(*lemon_convert(input_graph), lemon_mcf::network_simplex, false);
+}
+
 // NetworkSimplex minimum length
-void lemon_ns_minlen(Flowgraph<Edge::Minflow> &input_graph) {
-	auto mf = lemon_minflow(input_graph, true);
-	NetworkSimplex<ListDigraph> ns(mf.g);
-	ns.stSupply(mf.source, mf.sink, input_graph.n);
-	ns.lowerMap(*mf.demand);
-	ns.costMap(*mf.cost);
-	ns.run();
-	for(auto &[a,e]:mf.v_e) {
-		e->flow = ns.flow(a);
-	}
+template<typename T> void lemon_ns_minlen(Flowgraph<Edge::Minflow_t<T>> &input_graph) {
+	lemon_minflow_solve(*lemon_convert(input_graph), lemon_mcf::network_simplex, true);
 }
 
 // CostScaling
-void lemon_cs(Flowgraph<Edge::Minflow> &input_graph) {
-	auto mf = lemon_minflow(input_graph, false);
-	CostScaling<ListDigraph> cs(mf.g);
-	cs.stSupply(mf.source, mf.sink, input_graph.n);
-	cs.lowerMap(*mf.demand);
-	cs.costMap(*mf.cost);
-	cs.run();
-	for(auto &[a,e]:mf.v_e) {
-		e->flow = cs.flow(a);
-	}
+template<typename T> void lemon_cs(Flowgraph<Edge::Minflow_t<T>> &input_graph) {
+	lemon_minflow_solve(*lemon_convert(input_graph), lemon_mcf::cost_scaling, false);
 }
 
 // CostScaling minimum length
-void lemon_cs_minlen(Flowgraph<Edge::Minflow> &input_graph) {
-	auto mf = lemon_minflow(input_graph, true);
-	CostScaling<ListDigraph> cs(mf.g);
-	cs.stSupply(mf.source, mf.sink, input_graph.n);
-	cs.lowerMap(*mf.demand);
-	cs.costMap(*mf.cost);
-	cs.run();
-	for(auto &[a,e]:mf.v_e) {
-		e->flow = cs.flow(a);
-	}
+template<typename T> void lemon_cs_minlen(Flowgraph<Edge::Minflow_t<T>> &input_graph) {
+	lemon_minflow_solve(*lemon_convert(input_graph), lemon_mcf::cost_scaling, true);
 }
 
-void lemon_caps(Flowgraph<Edge::Minflow> &input_graph) {
-	auto mf = lemon_minflow(input_graph, false);
-	CapacityScaling<ListDigraph> cs(mf.g);
-	cs.stSupply(mf.source, mf.sink, input_graph.n);
-	cs.lowerMap(*mf.demand);
-	cs.costMap(*mf.cost);
-	cs.run();
-	for(auto &[a,e]:mf.v_e) {
-		e->flow = cs.flow(a);
-	}
+template<typename T> void lemon_caps(Flowgraph<Edge::Minflow_t<T>> &input_graph) {
+	lemon_minflow_solve(*lemon_convert(input_graph), lemon_mcf::capacity_scaling, false);
 }
 
-void lemon_caps_minlen(Flowgraph<Edge::Minflow> &input_graph) {
-	auto mf = lemon_minflow(input_graph, true);
-	CapacityScaling<ListDigraph> cs(mf.g);
-	cs.stSupply(mf.source, mf.sink, input_graph.n);
-	cs.lowerMap(*mf.demand);
-	cs.costMap(*mf.cost);
-	cs.run();
-	for(auto &[a,e]:mf.v_e) {
-		e->flow = cs.flow(a);
-	}
+template<typename T> void lemon_caps_minlen(Flowgraph<Edge::Minflow_t<T>> &input_graph) {
+	lemon_minflow_solve(*lemon_convert(input_graph), lemon_mcf::capacity_scaling, true);
 }
 
-void lemon_cc(Flowgraph<Edge::Minflow> &input_graph) {
-	auto mf = lemon_minflow(input_graph, false);
-	CycleCanceling<ListDigraph> cc(mf.g);
-	cc.stSupply(mf.source, mf.sink, input_graph.n);
-	cc.lowerMap(*mf.demand);
-	cc.costMap(*mf.cost);
-	cc.run();
-	for(auto &[a,e]:mf.v_e) {
-		e->flow = cc.flow(a);
-	}
+template<typename T> void lemon_cc(Flowgraph<Edge::Minflow_t<T>> &input_graph) {
+	lemon_minflow_solve(*lemon_convert(input_graph), lemon_mcf::cycle_canceling, false);
 }
 
-void lemon_cc_minlen(Flowgraph<Edge::Minflow> &input_graph) {
-	auto mf = lemon_minflow(input_graph, true);
-	CycleCanceling<ListDigraph> cc(mf.g);
-	cc.stSupply(mf.source, mf.sink, input_graph.n);
-	cc.lowerMap(*mf.demand);
-	cc.costMap(*mf.cost);
-	cc.run();
-	for(auto &[a,e]:mf.v_e) {
-		e->flow = cc.flow(a);
-	}
+template<typename T> void lemon_cc_minlen(Flowgraph<Edge::Minflow_t<T>> &input_graph) {
+	lemon_minflow_solve(*lemon_convert(input_graph), lemon_mcf::cycle_canceling, true);
 }
+
+#define LEMON_INSTANTIATE(T) \
+	template void lemon_preflow<T>(Flowgraph<Edge::Maxflow_t<T>>&); \
+	template std::shared_ptr<lemon_network<T>> lemon_convert<T>(Flowgraph<Edge::Minflow_t<T>>&); \
+	template void lemon_minflow_solve<T>(lemon_network<T>&, lemon_mcf, bool); \
+	template void lemon_ns<T>(Flowgraph<Edge::Minflow_t<T>>&); \
+	template void lemon_ns_minlen<T>(Flowgraph<Edge::Minflow_t<T>>&); \
+	template void lemon_cs<T>(Flowgraph<Edge::Minflow_t<T>>&); \
+	template void lemon_cs_minlen<T>(Flowgraph<Edge::Minflow_t<T>>&); \
+	template void lemon_cc<T>(Flowgraph<Edge::Minflow_t<T>>&); \
+	template void lemon_cc_minlen<T>(Flowgraph<Edge::Minflow_t<T>>&); \
+	template void lemon_caps<T>(Flowgraph<Edge::Minflow_t<T>>&); \
+	template void lemon_caps_minlen<T>(Flowgraph<Edge::Minflow_t<T>>&);
+LEMON_INSTANTIATE(int)
+LEMON_INSTANTIATE(long long)
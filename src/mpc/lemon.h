@@ -1,11 +1,21 @@
 #include "graph.h"
+#include <memory>
 
-void lemon_preflow(Flowgraph<Edge::Maxflow> &input_graph);
-void lemon_ns(Flowgraph<Edge::Minflow> &input_graph);
-void lemon_ns_minlen(Flowgraph<Edge::Minflow> &input_graph);
-void lemon_cs(Flowgraph<Edge::Minflow> &input_graph);
-void lemon_cs_minlen(Flowgraph<Edge::Minflow> &input_graph);
-void lemon_cc(Flowgraph<Edge::Minflow> &input_graph);
-void lemon_cc_minlen(Flowgraph<Edge::Minflow> &input_graph);
-void lemon_caps(Flowgraph<Edge::Minflow> &input_graph);
-void lemon_caps_minlen(Flowgraph<Edge::Minflow> &input_graph);
+// Instantiated for int and long long flow values (see Edge::Minflow_t)
+template<typename T> void lemon_preflow(Flowgraph<Edge::Maxflow_t<T>> &input_graph);
+template<typename T> void lemon_ns(Flowgraph<Edge::Minflow_t<T>> &input_graph);
+template<typename T> void lemon_ns_minlen(Flowgraph<Edge::Minflow_t<T>> &input_graph);
+template<typename T> void lemon_cs(Flowgraph<Edge::Minflow_t<T>> &input_graph);
+template<typename T> void lemon_cs_minlen(Flowgraph<Edge::Minflow_t<T>> &input_graph);
+template<typename T> void lemon_cc(Flowgraph<Edge::Minflow_t<T>> &input_graph);
+template<typename T> void lemon_cc_minlen(Flowgraph<Edge::Minflow_t<T>> &input_graph);
+template<typename T> void lemon_caps(Flowgraph<Edge::Minflow_t<T>> &input_graph);
+template<typename T> void lemon_caps_minlen(Flowgraph<Edge::Minflow_t<T>> &input_graph);
+
+// Minimum flow network converted to a LEMON StaticDigraph, it can be reused by several solvers as long as
+// the structure of input_graph does not change, flows are written back to the edges of input_graph
+template<typename T> struct lemon_network;
+template<typename T> std::shared_ptr<lemon_network<T>> lemon_convert(Flowgraph<Edge::Minflow_t<T>> &input_graph);
+
+enum class lemon_mcf {network_simplex, cost_scaling, cycle_canceling, capacity_scaling};
+template<typename T> void lemon_minflow_solve(lemon_network<T> &net, lemon_mcf algorithm, bool minlen);
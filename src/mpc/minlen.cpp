@@ -0,0 +1,136 @@
+#include "minlen.h"
+#include "naive.h"
+#include "cancel.h"
+#include <vector>
+#include <queue>
+#include <limits>
+#include <functional>
+#include <utility>
+#include <algorithm>
+
+// Successive shortest paths with potentials. Every v_in->v_out edge is first lowered to its demand, the
+// removed flow becomes excess at v_in and deficit at v_out. With zero potentials the residual has no negative
+// edges (cost 1 on v_in->v_out, 0 elsewhere), so the excess is routed back with Dijkstra on reduced costs and
+// augmenting along zero reduced cost edges. There is no sink->source edge so the flow value does not change.
+void minflow_minlen_solve(Flowgraph<Edge::Minflow> &fg) {
+	assert(is_valid_minflow(fg));
+	auto cost = [&fg](int a, int b){return (a != fg.source && a%2 == 1 && b == a+1) ? 1 : 0;}; // v_in->v_out
+	std::vector<int> excess(fg.n+1);
+	for(int i=1; i<=fg.n; i++) {
+		for(auto &[u,e]:fg.edge_out[i]) {
+			if(cost(i, u) && e->flow > e->demand) {
+				excess[i] += e->flow - e->demand;
+				excess[u] -= e->flow - e->demand;
+				e->flow = e->demand;
+			}
+		}
+	}
+	// Potentials only change for nodes settled by Dijkstra (shifted by the distance of the closest deficit)
+	const long long inf = std::numeric_limits<long long>::max();
+	std::vector<long long> pot(fg.n+1), dist(fg.n+1, inf);
+	std::vector<bool> visited(fg.n+1);
+	std::vector<int> sources, touched, settled;
+	for(int i=1; i<=fg.n; i++)
+		if(excess[i] > 0)
+			sources.push_back(i);
+	while(true) {
+		sources.erase(std::remove_if(sources.begin(), sources.end(), [&excess](int s){return excess[s] == 0;}), sources.end());
+		if(sources.empty())
+			break;
+		for(auto u:touched)
+			dist[u] = inf;
+		touched.clear();
+		settled.clear();
+		std::priority_queue<std::pair<long long,int>, std::vector<std::pair<long long,int>>, std::greater<std::pair<long long,int>>> pq;
+		for(auto u:sources) {
+			dist[u] = 0;
+			touched.push_back(u);
+			pq.push({0, u});
+		}
+		long long limit = inf; // distance to the closest deficit
+		auto relax = [&dist, &touched, &pq](int u, long long nd) {
+			if(nd < dist[u]) {
+				if(dist[u] == inf)
+					touched.push_back(u);
+				dist[u] = nd;
+				pq.push({nd, u});
+			}
+		};
+		while(!pq.empty()) {
+			auto [d, s] = pq.top();
+			pq.pop();
+			cancel_point();
+			if(d > dist[s])
+				continue;
+			settled.push_back(s);
+			if(excess[s] < 0) {
+				limit = d;
+				break;
+			}
+			for(auto &[u,e]:fg.edge_out[s])
+				relax(u, d + cost(s, u) + pot[s] - pot[u]);
+			for(auto &[u,e]:fg.edge_in[s])
+				if(e->flow > e->demand)
+					relax(u, d - cost(u, s) + pot[s] - pot[u]);
+		}
+		if(limit == inf)
+			break;
+		for(auto u:settled)
+			pot[u] += dist[u] - limit;
+		// Nodes of failed searches can not reach a deficit in this phase, found paths are augmented by their bottleneck
+		std::vector<int> visited_reset;
+		struct pe {
+			Edge::Minflow *e;
+			bool reverse;
+		};
+		std::vector<pe> path;
+		auto dfs = [&fg, &cost, &pot, &excess, &visited, &visited_reset, &path](auto dfs, int s)->int {
+			if(excess[s] < 0)
+				return s;
+			visited[s] = 1;
+			visited_reset.push_back(s);
+			for(auto &[u,e]:fg.edge_out[s]) {
+				if(visited[u] || cost(s, u) + pot[s] - pot[u] != 0)
+					continue;
+				path.push_back({e, false});
+				int t = dfs(dfs, u);
+				if(t) {
+					visited[s] = 0;
+					return t;
+				}
+				path.pop_back();
+			}
+			for(auto &[u,e]:fg.edge_in[s]) {
+				if(visited[u] || e->flow <= e->demand || pot[s] - cost(u, s) - pot[u] != 0)
+					continue;
+				path.push_back({e, true});
+				int t = dfs(dfs, u);
+				if(t) {
+					visited[s] = 0;
+					return t;
+				}
+				path.pop_back();
+			}
+			return 0;
+		};
+		for(auto u:sources) {
+			while(excess[u] > 0) {
+				path.clear();
+				int t = dfs(dfs, u);
+				if(!t)
+					break;
+				int delta = std::min(excess[u], -excess[t]);
+				for(auto &p:path)
+					if(p.reverse)
+						delta = std::min(delta, p.e->flow - p.e->demand);
+				for(auto &p:path)
+					p.e->flow += p.reverse ? -delta : delta;
+				excess[u] -= delta;
+				excess[t] += delta;
+			}
+		}
+		for(auto u:visited_reset)
+			visited[u] = 0;
+	}
+	assert(is_valid_minflow(fg));
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include "graph.h"
+
+// Input graph should have valid and satisfied minflow (e.g. from pflowk2), the flow value stays the same
+// and the total length (flow of v_in->v_out edges) is minimized
+void minflow_minlen_solve(Flowgraph<Edge::Minflow> &fg);
@@ -0,0 +1,99 @@
+#include "multilevel.h"
+#include "decremental.h"
+#include "pflow.h"
+#include <algorithm>
+
+coarse_graph coarsen(Graph &g, bool pairs) {
+	std::vector<int> next(g.n+1), prev(g.n+1);
+	for(int v=1; v<=g.n; v++)
+		if(g.edge_out[v].size() == 1 && g.edge_in[g.edge_out[v][0]].size() == 1) {
+			next[v] = g.edge_out[v][0];
+			prev[next[v]] = v;
+		}
+	if(pairs) {
+		// An unmatched vertex takes the unmatched out-neighbour with the fewest in-neighbours (the edges it drops),
+		// only if it is its single out-neighbour or the vertex is its single in-neighbour
+		std::vector<bool> matched(g.n+1);
+		for(auto u:topological_order(g, topo_order::dfs)) {
+			if(matched[u] || next[u] || prev[u])
+				continue;
+			int best = 0;
+			for(auto v:g.edge_out[u])
+				if(!matched[v] && !next[v] && !prev[v] && (g.edge_out[u].size() == 1 || g.edge_in[v].size() == 1) && (!best || g.edge_in[v].size() < g.edge_in[best].size()))
+					best = v;
+			if(best) {
+				next[u] = best;
+				prev[best] = u;
+				matched[u] = matched[best] = true;
+			}
+		}
+	}
+	coarse_graph ret;
+	std::vector<int> id(g.n+1);
+	ret.members.push_back({});
+	for(int v=1; v<=g.n; v++) {
+		if(prev[v])
+			continue;
+		ret.members.push_back({});
+		for(int u=v; u; u=next[u]) {
+			ret.members.back().push_back(u);
+			id[u] = ret.members.size()-1;
+		}
+	}
+	int n = ret.members.size()-1;
+	ret.g = std::make_unique<Graph>(n);
+	for(int c=1; c<=n; c++)
+		for(auto u:g.edge_out[ret.members[c].back()])
+			if(!prev[u])
+				ret.g->add_edge(c, id[u]);
+	return ret;
+}
+
+std::unique_ptr<Flowgraph<Edge::Minflow>> multilevel_minflow(Graph &g, minflow_solver solver, int coarse_n, bool pairs, multilevel_stats *stats) {
+	std::vector<coarse_graph> levels;
+	Graph *cur = &g;
+	while(cur->n > coarse_n) {
+		auto c = coarsen(*cur, pairs);
+		if(c.g->n > 0.9*cur->n)
+			break;
+		levels.push_back(std::move(c));
+		cur = levels.back().g.get();
+	}
+	auto fg = solver(*cur);
+	if(stats) {
+		*stats = {};
+		stats->n.resize(levels.size()+1);
+		stats->m.resize(levels.size()+1);
+		stats->width.resize(levels.size()+1);
+		stats->repaired.resize(levels.size()+1);
+		stats->n[levels.size()] = cur->n;
+		stats->m[levels.size()] = cur->count_edges();
+	}
+	for(int l=levels.size()-1; l>=0; l--) {
+		Graph &fine = l ? *levels[l-1].g : g;
+		auto coarse_cover = minflow_reduction_path_recover_faster(*fg);
+		if(stats)
+			stats->width[l+1] = coarse_cover.size();
+		path_cover pc(coarse_cover.size());
+		for(int i=0; i<coarse_cover.size(); i++)
+			for(auto c:coarse_cover[i])
+				pc[i].insert(pc[i].end(), levels[l].members[c].begin(), levels[l].members[c].end());
+		fg = cover_minflow_reduction(fine, pc);
+		minflow_decremental dec(*fg);
+		for(auto &[u,e]:fg->edge_out[fg->source])
+			if(e->flow > 0)
+				dec.touched.push_back(u);
+		int repaired = dec.repair();
+		if(stats) {
+			stats->n[l] = fine.n;
+			stats->m[l] = fine.count_edges();
+			stats->repaired[l] = repaired;
+		}
+	}
+	if(stats) {
+		stats->width[0] = 0;
+		for(auto &[u,e]:fg->edge_out[fg->source])
+			stats->width[0] += e->flow;
+	}
+	return fg;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "graph.h"
+#include "naive.h"
+#include "components.h"
+
+// Sizes of the levels of multilevel_minflow, level 0 is the input graph
+struct multilevel_stats {
+	std::vector<int> n, m, width;
+	std::vector<int> repaired; // decrementing paths found when projecting onto the level
+};
+
+// One level of coarsening. Coarse vertex c stands for the path members[c] of g (1-based like the vertices), made of
+// maximal chains (a vertex with a single out-neighbour that has it as single in-neighbour) and, if pairs, edges to a
+// single out-neighbour or from a single in-neighbour matched greedily in topological order. The coarse graph has an edge c->d iff g has the edge from the last vertex
+// of c to the first of d, so a path of the coarse graph expands to a path of g
+struct coarse_graph {
+	std::unique_ptr<Graph> g;
+	std::vector<std::vector<int>> members;
+};
+coarse_graph coarsen(Graph &g, bool pairs);
+
+// MPC of g by multilevel coarsening: g is coarsened until it has at most coarse_n vertices or a level shrinks it by
+// less than 10%, the coarsest graph is solved by solver and its cover is expanded level by level. The expanded cover
+// of a level is a feasible flow of its full reduction, made minimal by decrementing paths from all path starts
+// (minflow_decremental), so the result is exact. Chains alone keep the width, matched pairs can drop edges
+std::unique_ptr<Flowgraph<Edge::Minflow>> multilevel_minflow(Graph &g, minflow_solver solver, int coarse_n, bool pairs=true, multilevel_stats *stats=nullptr);
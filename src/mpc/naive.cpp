@@ -1,5 +1,8 @@
 #include "naive.h"
 #include "graph.h"
+#include "pflow.h"
+#include "cancel.h"
+#include "pool.h"
 #include <cassert>
 #include <algorithm>
 #include <array>
@@ -11,18 +14,19 @@
 #include <utility>
 #include <iostream>
 #include <memory>
+#include <atomic>
 
 // Input graph should have valid and satisfied minflow
-void minflow_maxflow_reduction(Flowgraph<Edge::Minflow> &fg, std::function<void(Flowgraph<Edge::Maxflow>&)> maxflow_solver) {
+template<typename T> void minflow_maxflow_reduction(Flowgraph<Edge::Minflow_t<T>> &fg, typename maxflow_solver_fn<T>::type maxflow_solver) {
 	assert(is_valid_minflow(fg));
-	Flowgraph<Edge::Maxflow> fg_red(fg.n, fg.source, fg.sink);
+	Flowgraph<Edge::Maxflow_t<T>> fg_red(fg.n, fg.source, fg.sink);
 	struct reduction_edge {
-		Edge::Maxflow &e_reduction;
-		Edge::Minflow &e_original;
+		Edge::Maxflow_t<T> &e_reduction;
+		Edge::Minflow_t<T> &e_original;
 		bool reverse;
 	};
 	std::vector<reduction_edge> v;
-	int flow = 0;
+	T flow = 0;
 	for(auto &[u,e]:fg.edge_out[fg.source])
 		flow += e->flow;
 	for(int i=1; i<=fg.n; i++) {
@@ -53,7 +57,7 @@ void minflow_maxflow_reduction(Flowgraph<Edge::Minflow> &fg, std::function<void(
 
 // Dinitz’ Algorithm: The Original Version and Even’s Version 233
 // Implementation of DA by Cherkassky
-void maxflow_solve_edmonds_karp_DMOD(Flowgraph<Edge::Maxflow> &fg) {
+template<typename T> void maxflow_solve_edmonds_karp_DMOD(Flowgraph<Edge::Maxflow_t<T>> &fg) {
 	while(true) {
 		std::vector<int> vis(fg.n+1, 0);
 		std::vector<int> dist(fg.n+1, std::numeric_limits<int>::max());
@@ -64,6 +68,7 @@ void maxflow_solve_edmonds_karp_DMOD(Flowgraph<Edge::Maxflow> &fg) {
 		while(!q.empty()) {
 			int cur = q.front();
 			q.pop();
+			cancel_point();
 			for(auto &[u,e]:fg.edge_out[cur]) {
 				if(e->flow == 0 || vis[u])
 					continue;
@@ -84,7 +89,7 @@ void maxflow_solve_edmonds_karp_DMOD(Flowgraph<Edge::Maxflow> &fg) {
 		}
 		std::fill(vis.begin(), vis.end(), 0);
 		struct pe {
-			Edge::Maxflow *e;
+			Edge::Maxflow_t<T> *e;
 			bool reverse;
 		};
 		std::vector<pe> path;
@@ -92,6 +97,7 @@ void maxflow_solve_edmonds_karp_DMOD(Flowgraph<Edge::Maxflow> &fg) {
 			if(vis[s])
 				return false;
 			vis[s] = 1;
+			cancel_point();
 			for(auto &[u,e]:fg.edge_out[s]) {
 				if(e->capacity <= e->flow || dist[s]-1 != dist[u])
 					continue;
@@ -109,7 +115,7 @@ void maxflow_solve_edmonds_karp_DMOD(Flowgraph<Edge::Maxflow> &fg) {
 				path.pop_back();
 			}
 			if(s == fg.sink) {
-				int e = std::numeric_limits<int>::max();
+				T e = std::numeric_limits<T>::max();
 				for(auto u:path) {
 					if(u.reverse)
 						e = std::min(u.e->flow, e);
@@ -133,14 +139,15 @@ void maxflow_solve_edmonds_karp_DMOD(Flowgraph<Edge::Maxflow> &fg) {
 	}
 }
 
-void maxflow_solve_edmonds_karp(Flowgraph<Edge::Maxflow> &fg) {
+template<typename T> void maxflow_solve_edmonds_karp(Flowgraph<Edge::Maxflow_t<T>> &fg) {
 	while(true) {
-		std::vector<std::pair<int,Edge::Maxflow*>> visited(fg.n+1);
+		std::vector<std::pair<int,Edge::Maxflow_t<T>*>> visited(fg.n+1);
 		std::queue<int> q;
 		q.push(fg.source);
 		while(!q.empty()) {
 			int cur = q.front();
 			q.pop();
+			cancel_point();
 			if(cur == fg.sink) {
 				break;
 			}
@@ -162,7 +169,7 @@ void maxflow_solve_edmonds_karp(Flowgraph<Edge::Maxflow> &fg) {
 		if(!visited[fg.sink].first)
 			break;
 		int cur = fg.sink;
-		int delta_flow = std::numeric_limits<int>::max();
+		T delta_flow = std::numeric_limits<T>::max();
 		while(cur != fg.source) {
 			if(visited[cur].first > 0) {
 				delta_flow = std::min(delta_flow, visited[cur].second->capacity-visited[cur].second->flow);
@@ -198,6 +205,7 @@ path_cover minflow_reduction_path_recover_faster(Flowgraph<Edge::Minflow> &fg) {
 			if(s == fg.sink) 
 				return true;
 			visited[s] = 1;
+			cancel_point();
 			while(edge_ptr[s] < fg.edge_out[s].end()) {
 				auto &[u,e] = *(edge_ptr[s]);
 				if(visited[u] || e->flow == 0) {
@@ -286,6 +294,7 @@ path_cover minflow_reduction_path_recover(Flowgraph<Edge::Minflow> &fg) {
 			if(s == fg.sink) 
 				return true;
 			visited[s] = 1;
+			cancel_point();
 			for(auto &[u, e]:fg.edge_out[s]) {
 				if(visited[u] || e->flow == 0)
 					continue;
@@ -316,7 +325,7 @@ path_cover minflow_reduction_path_recover(Flowgraph<Edge::Minflow> &fg) {
 }
 
 // Find augmenting paths 1 by 1 from residual graph with dfs
-void naive_minflow_solve(Flowgraph<Edge::Minflow> &fg) {
+template<typename T> void naive_minflow_solve(Flowgraph<Edge::Minflow_t<T>> &fg) {
 	std::vector<bool> visited(fg.n+1);
 	while(true) {
 		std::fill(visited.begin(), visited.end(), 0);
@@ -324,6 +333,7 @@ void naive_minflow_solve(Flowgraph<Edge::Minflow> &fg) {
 			if(s == fg.sink)
 				return true;
 			visited[s] = 1;
+			cancel_point();
 			for(auto &[u, e]:fg.edge_out[s]) {
 				if(visited[u] || e->demand >= e->flow)
 					continue;
@@ -347,11 +357,11 @@ void naive_minflow_solve(Flowgraph<Edge::Minflow> &fg) {
 	}
 }
 
-std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction_sparsified(Graph &g, std::function<int(int)> node_weight) {
+template<typename T> std::unique_ptr<Flowgraph<Edge::Minflow_t<T>>> greedy_minflow_reduction_sparsified(Graph &g, std::function<T(int)> node_weight) {
 	struct ggraph {
 		int n;
 		struct edge {
-			int flow = 0;
+			T flow = 0;
 		};
 		std::vector<std::vector<std::pair<int, edge>>> edge_in;
 		ggraph(int n):n(n) {
@@ -376,21 +386,24 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction_sparsified(Gr
 	}
 
 	struct Node_flow {
-		int source;
-		int sink;
-		int flow;
+		T source;
+		T sink;
+		T flow;
 	};
 	std::vector<Node_flow> node_flow(g.n+1);
 	std::vector<int> max_len(g.n+1);
-	std::vector<bool> not_covered(g.n+1, 1);
+	std::vector<T> not_covered(g.n+1); // demand left
+	for(int i=1; i<=g.n; i++)
+		not_covered[i] = node_weight(i);
 	while(true) {
-		std::vector<std::pair<int, ggraph::edge*>> to(g.n+1);
+		std::vector<std::pair<int, typename ggraph::edge*>> to(g.n+1);
 		std::fill(max_len.begin(), max_len.end(), 0);
 		std::pair<int, int> best_node = {0,0};
 		std::vector<bool> v2(g.n+1);
 		for(auto s:topo) {
+			cancel_point();
 			v2[s] = 1;
-			if(not_covered[s])
+			if(not_covered[s] > 0)
 				max_len[s]++;
 			if(max_len[s] > best_node.second)
 				best_node = {s, max_len[s]};
@@ -406,19 +419,24 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction_sparsified(Gr
 		};
 		if(best_node.first == 0)
 			break;
+		// The path carries the smallest demand left on it, so at least one vertex is covered completely
+		T c = std::numeric_limits<T>::max();
+		for(int cur = best_node.first; cur != 0; cur = to[cur].first)
+			if(not_covered[cur] > 0)
+				c = std::min(c, not_covered[cur]);
 		int cur = best_node.first;
-		node_flow[cur].source++;
+		node_flow[cur].source += c;
 		std::vector<bool> reach(g.n+1);
 		for(auto &[u, e]:gg.edge_in[cur]) {
 			reach[u] = 1;
 		}
 		while(to[cur].first != 0) {
 			// Sparsify
-			not_covered[cur] = 0;
-			to[cur].second->flow++;
-			node_flow[cur].flow++;
+			not_covered[cur] = std::max(T(0), not_covered[cur]-c);
+			to[cur].second->flow += c;
+			node_flow[cur].flow += c;
 			cur = to[cur].first;
-			std::vector<std::pair<int, ggraph::edge>> sparsified;
+			std::vector<std::pair<int, typename ggraph::edge>> sparsified;
 			for(auto &[u, e]:gg.edge_in[cur]) {
 				if(e.flow > 0 || !reach[u])
 					sparsified.push_back({u,{e.flow}});
@@ -428,14 +446,14 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction_sparsified(Gr
 			for(auto u:sparsified)
 				gg.edge_in[cur].push_back(u);
 		}
-		not_covered[cur] = 0;
-		node_flow[cur].flow++;
-		node_flow[cur].sink++;
+		not_covered[cur] = std::max(T(0), not_covered[cur]-c);
+		node_flow[cur].flow += c;
+		node_flow[cur].sink += c;
 	}
 	// Reduce to minflow
 	int source = g.n*2+1;
 	int sink = g.n*2+2;
-	auto fgo = std::make_unique<Flowgraph<Edge::Minflow>>(g.n*2+2, source, sink);
+	auto fgo = std::make_unique<Flowgraph<Edge::Minflow_t<T>>>(g.n*2+2, source, sink);
 	auto v_in = [](int v){return v*2-1;};
 	auto v_out = [](int v){return v*2;};
 	for(int i=1; i<=g.n; i++) {
@@ -443,8 +461,8 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction_sparsified(Gr
 			auto *e2 = fgo->add_edge(v_out(u), v_in(i));
 			e2->flow = e.flow;
 		}
-		Edge::Minflow *e = fgo->add_edge(v_in(i), v_out(i));
-		e->demand = 1;
+		Edge::Minflow_t<T> *e = fgo->add_edge(v_in(i), v_out(i));
+		e->demand = node_weight(i);
 		e->flow = node_flow[i].flow;
 		e = fgo->add_edge(source, v_in(i));
 		e->demand = 0;
@@ -457,8 +475,8 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction_sparsified(Gr
 	return fgo;
 }
 
-std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction(Graph &g, std::function<int(int)> node_weight) {
-	Flowgraph<Edge::Minflow> tfg = {g.n, 0, 0};
+template<typename T> std::unique_ptr<Flowgraph<Edge::Minflow_t<T>>> greedy_minflow_reduction(Graph &g, std::function<T(int)> node_weight) {
+	Flowgraph<Edge::Minflow_t<T>> tfg = {g.n, 0, 0};
 	std::vector<int> topo;
 	std::vector<bool> visited(g.n+1);
 	auto dfs = [&tfg, &g, &visited, &topo](auto dfs, int s) {
@@ -485,19 +503,22 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction(Graph &g, std
 	std::reverse(topo.begin(), topo.end());
 
 	struct Node_flow {
-		int source;
-		int sink;
-		int flow;
+		T source;
+		T sink;
+		T flow;
 	};
 	std::vector<Node_flow> node_flow(g.n+1);
 	std::vector<int> max_len(g.n+1);
-	std::vector<std::pair<int, Edge::Minflow*>> from(g.n+1);
-	auto &not_covered = visited;
+	std::vector<std::pair<int, Edge::Minflow_t<T>*>> from(g.n+1);
+	std::vector<T> not_covered(g.n+1); // demand left
+	for(int i=1; i<=g.n; i++)
+		not_covered[i] = node_weight(i);
 	while(true) {
 		std::fill(max_len.begin(), max_len.end(), 0);
 		std::pair<int, int> best_node = {0,0};
 		for(auto s:topo) {
-			if(not_covered[s])
+			cancel_point();
+			if(not_covered[s] > 0)
 				max_len[s]++;
 			if(max_len[s] > best_node.second)
 				best_node = {s, max_len[s]};
@@ -513,22 +534,27 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction(Graph &g, std
 		}
 		if(best_node.first == 0)
 			break;
+		// The path carries the smallest demand left on it, so at least one vertex is covered completely
+		T c = std::numeric_limits<T>::max();
+		for(int cur = best_node.first; cur != 0; cur = from[cur].first)
+			if(not_covered[cur] > 0)
+				c = std::min(c, not_covered[cur]);
 		int cur = best_node.first;
-		node_flow[cur].sink++;
+		node_flow[cur].sink += c;
 		while(from[cur].first != 0) {
-			not_covered[cur] = 0;
-			from[cur].second->flow++;
-			node_flow[cur].flow++;
+			not_covered[cur] = std::max(T(0), not_covered[cur]-c);
+			from[cur].second->flow += c;
+			node_flow[cur].flow += c;
 			cur = from[cur].first;
 		}
-		not_covered[cur] = 0;
-		node_flow[cur].flow++;
-		node_flow[cur].source++;
+		not_covered[cur] = std::max(T(0), not_covered[cur]-c);
+		node_flow[cur].flow += c;
+		node_flow[cur].source += c;
 	}
 	// Reduce to minflow
 	int source = g.n*2+1;
 	int sink = g.n*2+2;
-	auto fgo = std::make_unique<Flowgraph<Edge::Minflow>>(g.n*2+2, source, sink);
+	auto fgo = std::make_unique<Flowgraph<Edge::Minflow_t<T>>>(g.n*2+2, source, sink);
 	auto v_in = [](int v){return v*2-1;};
 	auto v_out = [](int v){return v*2;};
 	for(int i=1; i<=g.n; i++) {
@@ -536,8 +562,8 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction(Graph &g, std
 			auto *e2 = fgo->add_edge(v_out(i), v_in(u));
 			e2->flow = e->flow;
 		}
-		Edge::Minflow *e = fgo->add_edge(v_in(i), v_out(i));
-		e->demand = 1;
+		Edge::Minflow_t<T> *e = fgo->add_edge(v_in(i), v_out(i));
+		e->demand = node_weight(i);
 		e->flow = node_flow[i].flow;
 		e = fgo->add_edge(source, v_in(i));
 		e->demand = 0;
@@ -550,17 +576,149 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction(Graph &g, std
 	return fgo;
 }
 
-std::unique_ptr<Flowgraph<Edge::Minflow>> naive_minflow_reduction(Graph &g, std::function<int(int)> node_weight) {
+template<typename T> std::unique_ptr<Flowgraph<Edge::Minflow_t<T>>> greedy_minflow_reduction_incremental(Graph &g, int threads, std::function<T(int)> node_weight) {
 	int source = g.n*2+1;
 	int sink = g.n*2+2;
-	auto fgo = std::make_unique<Flowgraph<Edge::Minflow>>(g.n*2+2, source, sink);
+	auto fgo = std::make_unique<Flowgraph<Edge::Minflow_t<T>>>(g.n*2+2, source, sink);
+	auto v_in = [](int v){return v*2-1;};
+	auto v_out = [](int v){return v*2;};
+	std::vector<Edge::Minflow_t<T>*> demand(g.n+1), from_source(g.n+1), to_sink(g.n+1);
+	for(int i=1; i<=g.n; i++) {
+		for(auto &u:g.edge_in[i]) // the j-th in-edge of v_in(i) comes from g.edge_in[i][j]
+			fgo->add_edge(v_out(u), v_in(i));
+		demand[i] = fgo->add_edge(v_in(i), v_out(i));
+		demand[i]->demand = node_weight(i);
+		from_source[i] = fgo->add_edge(source, v_in(i));
+		to_sink[i] = fgo->add_edge(v_out(i), sink);
+	}
+	// Level of a vertex is its longest path from a source, the in-neighbours of a level are in earlier levels. The DP
+	// works on the positions of the vertices ordered by level (order), level l starting at start[l]
+	auto level = longest_path_levels(g);
+	int levels = g.n ? *std::max_element(level.begin(), level.end())+1 : 0;
+	std::vector<int> start(levels+1), order(g.n), at(g.n+1);
+	for(int i=1; i<=g.n; i++)
+		start[level[i]+1]++;
+	for(int l=0; l<levels; l++)
+		start[l+1] += start[l];
+	for(int i=1; i<=g.n; i++) {
+		at[i] = start[level[i]]++;
+		order[at[i]] = i;
+	}
+	for(int l=levels; l>0; l--)
+		start[l] = start[l-1];
+	start[0] = 0;
+	std::vector<int> in_start(g.n+1), in(g.count_edges()), out_start(g.n+1), out(in.size());
+	for(int p=0; p<g.n; p++) {
+		in_start[p+1] = in_start[p]+g.edge_in[order[p]].size();
+		out_start[p+1] = out_start[p]+g.edge_out[order[p]].size();
+		for(int j=0; j<g.edge_in[order[p]].size(); j++)
+			in[in_start[p]+j] = at[g.edge_in[order[p]][j]];
+		for(int j=0; j<g.edge_out[order[p]].size(); j++)
+			out[out_start[p]+j] = at[g.edge_out[order[p]][j]];
+	}
+
+	std::vector<T> not_covered(g.n); // demand left
+	std::vector<int> max_len(g.n), from(g.n); // from[p] is the index of the previous position in the in-list of p, or -1
+	std::vector<char> queued(g.n, 1), changed(g.n);
+	std::vector<std::vector<int>> bucket(g.n+1); // bucket[l] may hold positions no longer of length l
+	for(int p=0; p<g.n; p++)
+		not_covered[p] = node_weight(order[p]);
+	int first = 0, pending = g.n; // first queued position, number of queued positions
+	auto push = [&queued, &pending, &first](int p) {
+		if(queued[p])
+			return;
+		queued[p] = 1;
+		pending++;
+		first = std::min(first, p);
+	};
+	// Longest path of uncovered vertices ending at p, from the final values of the earlier levels
+	auto pull = [&in_start, &in, &max_len, &from, &not_covered, &changed](int p) {
+		int len = 0;
+		from[p] = -1;
+		for(int j=in_start[p]; j<in_start[p+1]; j++)
+			if(max_len[in[j]] > len) {
+				len = max_len[in[j]];
+				from[p] = j-in_start[p];
+			}
+		len += not_covered[p] > 0;
+		changed[p] = len != max_len[p];
+		max_len[p] = len;
+	};
+	// Only the downstream cone of the vertices covered completely by the last path can change
+	auto update = [&]() {
+		for(int l=pending > 0 ? level[order[first]] : 0; pending > 0; l++) {
+			int a = std::max(first, start[l]), b = start[l+1];
+			if(threads > 1 && b-a >= 4096) {
+				parallel_for(a, b, (b-a+threads-1)/threads, [&queued, &pull](int lo, int hi) {
+					for(int p=lo; p<hi; p++)
+						if(queued[p])
+							pull(p);
+				});
+			} else {
+				for(int p=a; p<b; p++)
+					if(queued[p])
+						pull(p);
+			}
+			cancel_point(b-a);
+			for(int p=a; p<b; p++) {
+				if(!queued[p])
+					continue;
+				queued[p] = 0;
+				pending--;
+				if(!changed[p])
+					continue;
+				bucket[max_len[p]].push_back(p);
+				for(int j=out_start[p]; j<out_start[p+1]; j++)
+					push(out[j]);
+			}
+		}
+		first = g.n;
+	};
+	update();
+	int best = g.n;
+	while(true) {
+		while(best > 0 && (bucket[best].empty() || max_len[bucket[best].back()] != best)) {
+			if(bucket[best].empty())
+				best--;
+			else
+				bucket[best].pop_back();
+		}
+		if(best == 0)
+			break;
+		// The path carries the smallest demand left on it, so at least one vertex is covered completely
+		T c = std::numeric_limits<T>::max();
+		for(int p = bucket[best].back(); p >= 0; p = from[p] < 0 ? -1 : in[in_start[p]+from[p]])
+			if(not_covered[p] > 0)
+				c = std::min(c, not_covered[p]);
+		int p = bucket[best].back();
+		to_sink[order[p]]->flow += c;
+		while(true) {
+			if(not_covered[p] > 0 && (not_covered[p] = std::max(T(0), not_covered[p]-c)) == 0)
+				push(p);
+			demand[order[p]]->flow += c;
+			if(from[p] < 0)
+				break;
+			fgo->edge_in[v_in(order[p])][from[p]].second->flow += c;
+			p = in[in_start[p]+from[p]];
+		}
+		from_source[order[p]]->flow += c;
+		update();
+	}
+	assert(is_valid_minflow(*fgo));
+	return fgo;
+}
+
+template<typename T> std::unique_ptr<Flowgraph<Edge::Minflow_t<T>>> naive_minflow_reduction(Graph &g, std::function<T(int)> node_weight) {
+	int source = g.n*2+1;
+	int sink = g.n*2+2;
+	auto fgo = std::make_unique<Flowgraph<Edge::Minflow_t<T>>>(g.n*2+2, source, sink);
 	auto v_in = [](int v){return v*2-1;};
 	auto v_out = [](int v){return v*2;};
 	for(int i=1; i<=g.n; i++) {
 		for(auto &u:g.edge_out[i]) {
 			fgo->add_edge(v_out(i), v_in(u));
 		}
-		Edge::Minflow *e = fgo->add_edge(v_in(i), v_out(i));
+		Edge::Minflow_t<T> *e = fgo->add_edge(v_in(i), v_out(i));
 		e->demand = node_weight(i);
 		e->flow = node_weight(i);
 		e = fgo->add_edge(source, v_in(i));
@@ -573,9 +731,200 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> naive_minflow_reduction(Graph &g, std:
 	return fgo;
 }
 
-bool is_valid_minflow(Flowgraph<Edge::Minflow> &fg) {
+std::unique_ptr<Flowgraph<Edge::Minflow>> full_minflow_reduction(Graph &g, Flowgraph<Edge::Minflow> &fg) {
+	assert(fg.n == g.n*2+2);
+	auto fgo = naive_minflow_reduction(g);
+	auto v_in = [](int v){return v*2-1;};
+	auto v_out = [](int v){return v*2;};
+	auto v_r = [](int v){return (v+1)/2;}; // fg -> original graph
+	for(int i=1; i<=fgo->n; i++)
+		for(auto &[u,e]:fgo->edge_out[i])
+			e->flow = 0;
+	// naive_minflow_reduction adds the edges of v_out(i) before v_out(i)->sink and source edges in order
+	for(auto &[u,e]:fg.edge_out[fg.source])
+		fgo->edge_out[fgo->source][v_r(u)-1].second->flow += e->flow;
+	std::vector<int> pos(g.n+1, -1);
+	for(int i=1; i<=g.n; i++) {
+		auto *e = fgo->edge_out[v_in(i)][0].second;
+		for(auto &[u,e2]:fg.edge_out[v_in(i)]) {
+			e->flow += e2->flow;
+			e->demand = e2->demand;
+		}
+		for(int j=0; j<g.edge_out[i].size(); j++)
+			pos[g.edge_out[i][j]] = j;
+		for(auto &[u,e2]:fg.edge_out[v_out(i)]) {
+			if(u == fg.sink) {
+				fgo->edge_out[v_out(i)].back().second->flow += e2->flow;
+			} else {
+				assert(pos[v_r(u)] != -1);
+				fgo->edge_out[v_out(i)][pos[v_r(u)]].second->flow += e2->flow;
+			}
+		}
+		for(auto &u:g.edge_out[i])
+			pos[u] = -1;
+	}
+	assert(is_valid_minflow(*fgo));
+	return fgo;
+}
+
+std::unique_ptr<Flowgraph<Edge::Minflow>> cover_minflow_reduction(Graph &g, path_cover &pc) {
+	auto fgo = naive_minflow_reduction(g);
+	auto v_in = [](int v){return v*2-1;};
+	auto v_out = [](int v){return v*2;};
+	for(int i=1; i<=fgo->n; i++)
+		for(auto &[u,e]:fgo->edge_out[i])
+			e->flow = 0;
+	// naive_minflow_reduction adds the edges of v_out(i) before v_out(i)->sink and source edges in order
+	auto start = [&fgo](int v){fgo->edge_out[fgo->source][v-1].second->flow++;};
+	auto end = [&fgo, &v_out](int v){fgo->edge_out[v_out(v)].back().second->flow++;};
+	auto cover = [&fgo, &v_in](int v){fgo->edge_out[v_in(v)][0].second->flow++;};
+	for(auto &path:pc) {
+		if(path.empty())
+			continue;
+		start(path[0]);
+		for(int j=0; j<path.size(); j++) {
+			int a = path[j];
+			assert(a >= 1 && a <= g.n);
+			cover(a);
+			if(j+1 == path.size()) {
+				end(a);
+				break;
+			}
+			auto it = std::find(g.edge_out[a].begin(), g.edge_out[a].end(), path[j+1]);
+			if(it == g.edge_out[a].end()) {
+				end(a);
+				start(path[j+1]);
+			} else {
+				fgo->edge_out[v_out(a)][it-g.edge_out[a].begin()].second->flow++;
+			}
+		}
+	}
+	for(int i=1; i<=g.n; i++) {
+		if(fgo->edge_out[v_in(i)][0].second->flow == 0) {
+			start(i);
+			cover(i);
+			end(i);
+		}
+	}
+	assert(is_valid_minflow(*fgo));
+	return fgo;
+}
+
+// Every edge is its own path
+std::unique_ptr<Flowgraph<Edge::Minflow>> naive_minflow_reduction_edges(Graph &g) {
+	int source = g.n*2+1;
+	int sink = g.n*2+2;
+	auto fgo = std::make_unique<Flowgraph<Edge::Minflow>>(g.n*2+2, source, sink);
+	auto v_in = [](int v){return v*2-1;};
+	auto v_out = [](int v){return v*2;};
+	for(int i=1; i<=g.n; i++) {
+		int in_deg = g.edge_in[i].size();
+		int out_deg = g.edge_out[i].size();
+		for(auto &u:g.edge_out[i]) {
+			auto *e = fgo->add_edge(v_out(i), v_in(u));
+			e->demand = 1;
+			e->flow = 1;
+		}
+		Edge::Minflow *e = fgo->add_edge(v_in(i), v_out(i));
+		e->demand = 0;
+		e->flow = in_deg+out_deg;
+		e = fgo->add_edge(source, v_in(i));
+		e->demand = 0;
+		e->flow = out_deg;
+		e = fgo->add_edge(v_out(i), sink);
+		e->demand = 0;
+		e->flow = in_deg;
+	}
+	return fgo;
+}
+
+// Same as greedy_minflow_reduction, but paths maximize the number of uncovered edges
+std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction_edges(Graph &g) {
+	std::vector<int> topo;
+	{std::vector<bool> visited(g.n+1);
+	auto dfs = [&g, &visited, &topo](auto dfs, int s) {
+		if(visited[s])
+			return;
+		visited[s] = 1;
+		for(auto &u:g.edge_out[s]) {
+			dfs(dfs, u);
+		}
+		topo.push_back(s);
+	};
+	for(int i=1; i<=g.n; i++)
+		dfs(dfs, i);
+	}
+	std::reverse(topo.begin(), topo.end());
+
+	struct Node_flow {
+		int source;
+		int sink;
+		int flow;
+	};
+	std::vector<Node_flow> node_flow(g.n+1);
+	std::vector<std::vector<int>> edge_flow(g.n+1); // flow of g.edge_out[i][j]
+	for(int i=1; i<=g.n; i++)
+		edge_flow[i].resize(g.edge_out[i].size());
+	std::vector<int> max_len(g.n+1);
+	std::vector<std::pair<int, int>> from(g.n+1); // (node, index in its edge_out)
+	while(true) {
+		std::fill(max_len.begin(), max_len.end(), 0);
+		std::fill(from.begin(), from.end(), std::pair<int,int>{0, 0});
+		std::pair<int, int> best_node = {0,0};
+		for(auto s:topo) {
+			if(max_len[s] > best_node.second)
+				best_node = {s, max_len[s]};
+			for(int j=0; j<g.edge_out[s].size(); j++) {
+				int u = g.edge_out[s][j];
+				int len = max_len[s] + (edge_flow[s][j] == 0);
+				if(len > max_len[u]) {
+					max_len[u] = len;
+					from[u] = {s, j};
+				}
+			}
+		}
+		if(best_node.first == 0)
+			break;
+		int cur = best_node.first;
+		node_flow[cur].sink++;
+		while(from[cur].first != 0) {
+			auto [u, j] = from[cur];
+			edge_flow[u][j]++;
+			node_flow[cur].flow++;
+			cur = u;
+		}
+		node_flow[cur].flow++;
+		node_flow[cur].source++;
+	}
+	// Reduce to minflow
+	int source = g.n*2+1;
+	int sink = g.n*2+2;
+	auto fgo = std::make_unique<Flowgraph<Edge::Minflow>>(g.n*2+2, source, sink);
+	auto v_in = [](int v){return v*2-1;};
+	auto v_out = [](int v){return v*2;};
+	for(int i=1; i<=g.n; i++) {
+		for(int j=0; j<g.edge_out[i].size(); j++) {
+			auto *e2 = fgo->add_edge(v_out(i), v_in(g.edge_out[i][j]));
+			e2->demand = 1;
+			e2->flow = edge_flow[i][j];
+		}
+		Edge::Minflow *e = fgo->add_edge(v_in(i), v_out(i));
+		e->demand = 0;
+		e->flow = node_flow[i].flow;
+		e = fgo->add_edge(source, v_in(i));
+		e->demand = 0;
+		e->flow = node_flow[i].source;
+		e = fgo->add_edge(v_out(i), sink);
+		e->demand = 0;
+		e->flow = node_flow[i].sink;
+	}
+	assert(is_valid_minflow(*fgo));
+	return fgo;
+}
+
+template<typename T> bool is_valid_minflow(Flowgraph<Edge::Minflow_t<T>> &fg) {
 	for(int i=1; i<=fg.n; i++) {
-		int total_out = 0;
+		T total_out = 0;
 		for(auto &[u,e]:fg.edge_out[i]) {
 			if(e->flow < e->demand) {
 				std::cout << "Demand not satisfied" << std::endl;
@@ -583,7 +932,7 @@ bool is_valid_minflow(Flowgraph<Edge::Minflow> &fg) {
 			}
 			total_out += e->flow;
 		}
-		int total_in = 0;
+		T total_in = 0;
 		for(auto &[u,e]:fg.edge_in[i])
 			total_in += e->flow;
 		if(i != fg.sink && i != fg.source && total_in != total_out) {
@@ -596,7 +945,7 @@ bool is_valid_minflow(Flowgraph<Edge::Minflow> &fg) {
 
 bool is_valid_cover(std::vector<std::vector<int>> &cover, Graph &g) {
 	std::vector<int> visited(g.n+1);
-	for(auto path:cover) {
+	for(auto &path:cover) {
 		for(auto &u:path) {
 			if(u < 1 || u > g.n) {
 				std::cout << " oob " << std::endl;
@@ -604,11 +953,20 @@ bool is_valid_cover(std::vector<std::vector<int>> &cover, Graph &g) {
 			}
 			visited[u] = 1;
 		}
-		for(int i=1; i<path.size(); i++)
-			if(!g.has_edge(path[i-1], path[i])) {
-				std::cout << " no edge " << std::endl;
-				return false;
-			}
+	}
+	// The edge lookups scan adjacency lists, the paths are checked on the pool
+	std::atomic<bool> edges(true);
+	parallel_for(0, cover.size(), 256, [&cover, &g, &edges](int lo, int hi) {
+		for(int p=lo; p<hi && edges; p++)
+			for(int i=1; i<cover[p].size(); i++)
+				if(!g.has_edge(cover[p][i-1], cover[p][i])) {
+					edges = false;
+					break;
+				}
+	});
+	if(!edges) {
+		std::cout << " no edge " << std::endl;
+		return false;
 	}
 	for(int i=1; i<=g.n; i++)
 		if(!visited[i]) {
@@ -617,3 +975,52 @@ bool is_valid_cover(std::vector<std::vector<int>> &cover, Graph &g) {
 		}
 	return true;
 }
+
+bool is_valid_edge_cover(std::vector<std::vector<int>> &cover, Graph &g) {
+	std::vector<std::vector<bool>> visited(g.n+1);
+	for(int i=1; i<=g.n; i++)
+		visited[i].resize(g.edge_out[i].size());
+	for(auto path:cover) {
+		for(auto &u:path) {
+			if(u < 1 || u > g.n) {
+				std::cout << " oob " << std::endl;
+				return false;
+			}
+		}
+		for(int i=1; i<path.size(); i++) {
+			auto &out = g.edge_out[path[i-1]];
+			auto it = std::find(out.begin(), out.end(), path[i]);
+			if(it == out.end()) {
+				std::cout << " no edge " << std::endl;
+				return false;
+			}
+			visited[path[i-1]][it-out.begin()] = 1;
+		}
+	}
+	for(int i=1; i<=g.n; i++)
+		for(int j=0; j<g.edge_out[i].size(); j++)
+			if(!visited[i][j]) {
+				std::cout << " no visit all "<< i << " " << g.edge_out[i][j] << std::endl;
+				return false;
+			}
+	return true;
+}
+
+template void minflow_maxflow_reduction<int>(Flowgraph<Edge::Minflow_t<int>>&, maxflow_solver_fn<int>::type);
+template void minflow_maxflow_reduction<long long>(Flowgraph<Edge::Minflow_t<long long>>&, maxflow_solver_fn<long long>::type);
+template void maxflow_solve_edmonds_karp_DMOD<int>(Flowgraph<Edge::Maxflow_t<int>>&);
+template void maxflow_solve_edmonds_karp_DMOD<long long>(Flowgraph<Edge::Maxflow_t<long long>>&);
+template void maxflow_solve_edmonds_karp<int>(Flowgraph<Edge::Maxflow_t<int>>&);
+template void maxflow_solve_edmonds_karp<long long>(Flowgraph<Edge::Maxflow_t<long long>>&);
+template void naive_minflow_solve<int>(Flowgraph<Edge::Minflow_t<int>>&);
+template void naive_minflow_solve<long long>(Flowgraph<Edge::Minflow_t<long long>>&);
+template std::unique_ptr<Flowgraph<Edge::Minflow_t<int>>> naive_minflow_reduction<int>(Graph&, std::function<int(int)>);
+template std::unique_ptr<Flowgraph<Edge::Minflow_t<long long>>> naive_minflow_reduction<long long>(Graph&, std::function<long long(int)>);
+template bool is_valid_minflow<int>(Flowgraph<Edge::Minflow_t<int>>&);
+template bool is_valid_minflow<long long>(Flowgraph<Edge::Minflow_t<long long>>&);
+template std::unique_ptr<Flowgraph<Edge::Minflow_t<int>>> greedy_minflow_reduction<int>(Graph&, std::function<int(int)>);
+template std::unique_ptr<Flowgraph<Edge::Minflow_t<long long>>> greedy_minflow_reduction<long long>(Graph&, std::function<long long(int)>);
+template std::unique_ptr<Flowgraph<Edge::Minflow_t<int>>> greedy_minflow_reduction_incremental<int>(Graph&, int, std::function<int(int)>);
+template std::unique_ptr<Flowgraph<Edge::Minflow_t<long long>>> greedy_minflow_reduction_incremental<long long>(Graph&, int, std::function<long long(int)>);
+template std::unique_ptr<Flowgraph<Edge::Minflow_t<int>>> greedy_minflow_reduction_sparsified<int>(Graph&, std::function<int(int)>);
+template std::unique_ptr<Flowgraph<Edge::Minflow_t<long long>>> greedy_minflow_reduction_sparsified<long long>(Graph&, std::function<long long(int)>);
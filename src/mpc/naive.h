@@ -9,17 +9,36 @@
 
 typedef std::vector<std::vector<int>> path_cover;
 
-void maxflow_solve_edmonds_karp(Flowgraph<Edge::Maxflow>& fg);
-void minflow_maxflow_reduction(Flowgraph<Edge::Minflow>&, std::function<void(Flowgraph<Edge::Maxflow>&)> maxflow_solver);
-bool is_valid_minflow(Flowgraph<Edge::Minflow>&);
+// Flow solvers are instantiated for int and long long flow values (see Edge::Minflow_t)
+template<typename T> struct maxflow_solver_fn {
+	typedef std::function<void(Flowgraph<Edge::Maxflow_t<T>>&)> type;
+};
+template<typename T> void maxflow_solve_edmonds_karp(Flowgraph<Edge::Maxflow_t<T>>& fg);
+template<typename T> void minflow_maxflow_reduction(Flowgraph<Edge::Minflow_t<T>>&, typename maxflow_solver_fn<T>::type maxflow_solver);
+template<typename T> bool is_valid_minflow(Flowgraph<Edge::Minflow_t<T>>&);
 void minflow_maxflow_reduction(Graph&);
 bool is_valid_cover(std::vector<std::vector<int>>&, Graph&);
+bool is_valid_edge_cover(std::vector<std::vector<int>>&, Graph&);
 path_cover minflow_reduction_path_recover(Flowgraph<Edge::Minflow>&);
 path_cover minflow_reduction_path_recover_fast(Flowgraph<Edge::Minflow>&);
 path_cover minflow_reduction_path_recover_faster(Flowgraph<Edge::Minflow>&);
-void naive_minflow_solve(Flowgraph<Edge::Minflow>& flowgraph);
-void maxflow_solve_edmonds_karp_DMOD(Flowgraph<Edge::Maxflow> &fg);
+template<typename T> void naive_minflow_solve(Flowgraph<Edge::Minflow_t<T>>& flowgraph);
+template<typename T> void maxflow_solve_edmonds_karp_DMOD(Flowgraph<Edge::Maxflow_t<T>> &fg);
 
-std::unique_ptr<Flowgraph<Edge::Minflow>> naive_minflow_reduction(Graph &g, std::function<int(int)> node_weight=[](int i){return 1;});
-std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction(Graph &g, std::function<int(int)> node_weight=[](int i){return 1;});
-std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction_sparsified(Graph &g, std::function<int(int)> node_weight=[](int i){return 1;});
+template<typename T=int> std::unique_ptr<Flowgraph<Edge::Minflow_t<T>>> naive_minflow_reduction(Graph &g, std::function<T(int)> node_weight=[](int i){return T(1);});
+// Greedy paths cover the most vertices with demand left and carry the smallest demand left on them
+template<typename T=int> std::unique_ptr<Flowgraph<Edge::Minflow_t<T>>> greedy_minflow_reduction(Graph &g, std::function<T(int)> node_weight=[](int i){return T(1);});
+// Greedy paths as above (ties broken differently), but after a path only the longest paths ending in the downstream
+// cone of its completely covered vertices are recomputed, level by level (longest path from a source). Levels of at
+// least 4096 vertices are split into threads tasks of the pool (pool.h)
+template<typename T=int> std::unique_ptr<Flowgraph<Edge::Minflow_t<T>>> greedy_minflow_reduction_incremental(Graph &g, int threads=1, std::function<T(int)> node_weight=[](int i){return T(1);});
+template<typename T=int> std::unique_ptr<Flowgraph<Edge::Minflow_t<T>>> greedy_minflow_reduction_sparsified(Graph &g, std::function<T(int)> node_weight=[](int i){return T(1);});
+// Reduction of g with every edge carrying the flow of fg, a reduction of g with a subset of the edges (e.g. from pflowk2)
+std::unique_ptr<Flowgraph<Edge::Minflow>> full_minflow_reduction(Graph &g, Flowgraph<Edge::Minflow> &fg);
+// Reduction of g with the flow of the paths of pc (e.g. a cover of an earlier version of g). A path is split where
+// consecutive vertices are not adjacent in g and vertices on no path get their own path
+std::unique_ptr<Flowgraph<Edge::Minflow>> cover_minflow_reduction(Graph &g, path_cover &pc);
+
+// Edge covering reductions, demand 1 is on every edge v_out(a)->v_in(b) instead of v_in(v)->v_out(v)
+std::unique_ptr<Flowgraph<Edge::Minflow>> naive_minflow_reduction_edges(Graph &g);
+std::unique_ptr<Flowgraph<Edge::Minflow>> greedy_minflow_reduction_edges(Graph &g);
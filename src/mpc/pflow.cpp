@@ -2,6 +2,7 @@
 #include <iterator>
 #include "naive.h"
 #include "graph.h"
+#include "cancel.h"
 #include <queue>
 #include <vector>
 #include <deque>
@@ -9,24 +10,161 @@
 #include <limits>
 #include <iostream>
 #include <list>
+#include <functional>
+#include <cstdint>
 
-std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
+const std::vector<std::pair<topo_order, std::string>> topo_orders = {
+	{topo_order::dfs, "dfs"},
+	{topo_order::kahn, "kahn"},
+	{topo_order::longest_path, "longest_path"},
+	{topo_order::reverse, "reverse"}};
+
+std::vector<int> longest_path_levels(Graph &g, std::vector<int> *kahn) {
+	std::vector<int> level(g.n+1), indegree(g.n+1), q;
+	q.reserve(g.n);
+	for(int i=1; i<=g.n; i++) {
+		indegree[i] = g.edge_in[i].size();
+		if(indegree[i] == 0)
+			q.push_back(i);
+	}
+	for(int h=0; h<q.size(); h++)
+		for(auto u:g.edge_out[q[h]]) {
+			level[u] = std::max(level[u], level[q[h]]+1);
+			if(--indegree[u] == 0)
+				q.push_back(u);
+		}
+	if(kahn)
+		*kahn = std::move(q);
+	return level;
+}
+
+std::vector<int> topological_order(Graph &g, topo_order order) {
 	std::vector<int> topo;
-	// Topo order O(n+m) OK
-	{
+	topo.reserve(g.n);
+	if(order == topo_order::reverse) {
+		Graph rg(g);
+		std::swap(rg.edge_in, rg.edge_out);
+		return topological_order(rg, topo_order::dfs);
+	}
+	if(order == topo_order::dfs) {
+		// Topo order O(n+m) OK
 		std::vector<bool> visited(g.n+1);
 		auto s1 = [&topo, &g, &visited](int s, auto dfs) {
 			if(visited[s])
 				return;
 			visited[s] = 1;
-			for(auto u:g.edge_in[s]) {
+			for(auto &u:g.edge_in[s]) {
 				dfs(u, dfs);
 			}
 			topo.push_back(s);
 		};
 		for(int i=1; i<=g.n; i++)
 			s1(i, s1);
+		return topo;
 	}
+	auto lvl = longest_path_levels(g, &topo);
+	if(order == topo_order::kahn)
+		return topo;
+	// Stable counting sort of the Kahn order by level
+	std::vector<int> start(g.n+1);
+	for(int i=1; i<=g.n; i++)
+		start[lvl[i]+1]++;
+	for(int l=0; l<g.n; l++)
+		start[l+1] += start[l];
+	std::vector<int> ret(g.n);
+	for(auto v:topo)
+		ret[start[lvl[v]]++] = v;
+	return ret;
+}
+
+// The same flow on the reversed graph: v_in and v_out swap, source and sink swap and every edge turns around
+static std::unique_ptr<Flowgraph<Edge::Minflow>> reverse_network(Flowgraph<Edge::Minflow> &fg) {
+	auto r = [&fg](int x) {
+		if(x == fg.source)
+			return fg.sink;
+		if(x == fg.sink)
+			return fg.source;
+		return x%2 ? x+1 : x-1;
+	};
+	auto ret = std::make_unique<Flowgraph<Edge::Minflow>>(fg.n, fg.source, fg.sink);
+	for(int x=1; x<=fg.n; x++) {
+		for(auto &[u,e]:fg.edge_out[x]) {
+			auto *e2 = ret->add_edge(r(u), r(x));
+			e2->demand = e->demand;
+			e2->flow = e->flow;
+		}
+	}
+	return ret;
+}
+
+// Path id sets of pflowk3, generic ids in vectors
+struct pathset_vector {
+	static const int max_paths = std::numeric_limits<int>::max();
+	typedef std::vector<int> set;
+	static void add(set &s, int id) {s.push_back(id);}
+	static void clear(set &s) {s.clear();}
+	template<typename F> static void for_each(const set &s, F f) {
+		for(auto u:s)
+			f(u);
+	}
+	// Used path marks and the last in-neighbour (topo index) per path while sparsifying
+	struct scratch {
+		std::vector<int> used, last;
+		scratch(int n):used(n),last(n, -1) {}
+		void clear_used(int paths) {std::fill(used.begin(), used.begin()+paths, 0);}
+		bool use(int id) {
+			if(used[id])
+				return false;
+			used[id] = 1;
+			return true;
+		}
+		void update(int id, int v) {last[id] = std::max(last[id], v);}
+		template<typename F> void drain(int paths, F f) {
+			for(int p=0; p<paths; p++) {
+				if(last[p] == -1)
+					continue;
+				f(last[p]);
+				last[p] = -1;
+			}
+		}
+	};
+};
+
+// Same with at most 64 paths as bits of a word
+struct pathset_word {
+	static const int max_paths = 64;
+	typedef uint64_t set;
+	static void add(set &s, int id) {s |= 1ULL << id;}
+	static void clear(set &s) {s = 0;}
+	template<typename F> static void for_each(set s, F f) {
+		for(; s; s &= s-1)
+			f(__builtin_ctzll(s));
+	}
+	struct scratch {
+		uint64_t used = 0, touched = 0;
+		int last[64];
+		scratch(int) {}
+		void clear_used(int) {used = 0;}
+		bool use(int id) {
+			if(used >> id & 1)
+				return false;
+			used |= 1ULL << id;
+			return true;
+		}
+		void update(int id, int v) {
+			last[id] = (touched >> id & 1) ? std::max(last[id], v) : v;
+			touched |= 1ULL << id;
+		}
+		template<typename F> void drain(int, F f) {
+			for(; touched; touched &= touched-1)
+				f(last[__builtin_ctzll(touched)]);
+		}
+	};
+};
+
+// Returns nullptr if more than P::max_paths paths are needed
+template<typename P> std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3_paths(Graph &g, topo_order order, pflow_stats &stats) {
+	std::vector<int> topo = topological_order(g, order);
 	std::vector<int> topo_idx(g.n+1);
 	for(int i=0; i<topo.size(); i++) {
 		topo_idx[topo[i]] = i;
@@ -37,7 +175,7 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
 	auto fgo = std::make_unique<Flowgraph<Edge::Minflow>>(g.n*2+2, g.n*2+1, g.n*2+2);
 	auto &fg = *fgo;
 	std::vector<int> pathid(g.n+1); // some path id for node x
-	std::vector<std::vector<int>> pathids(g.n+1); // path ids of a node x
+	std::vector<typename P::set> pathids(g.n+1); // path ids of a node x
 	int paths = 0; // how many paths in total
 	std::vector<int> path_ends; // Nodes in which flowpaths end
 	std::vector<int> layer(fg.n+1); // layer of node x
@@ -46,8 +184,22 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
 	layer[fg.sink] = std::numeric_limits<int>::max();
 	std::vector<std::pair<int, std::vector<std::pair<int, Edge::Minflow*>>::iterator>> path_s_v(fg.n+1, {-1, {}}); 
 	std::vector<bool> visited2(fg.n+2); 
-	std::vector<std::vector<int>> new_paths(g.n+1); 
+	std::vector<typename P::set> new_paths(g.n+1); 
 	std::vector<std::pair<int, Edge::Minflow*>> visited(fg.n+1); 
+	// Scratch buffers reused by every vertex, nothing below allocates per vertex once they have grown
+	typename P::scratch used_path(g.n);
+	std::vector<std::vector<int>> q;
+	std::vector<int> q_head;
+	std::vector<int> visited_v, visited_reset, path_s_v_reset, visited2_reset;
+	std::vector<std::vector<int>> layer_spare; // emptied layers keep their capacity
+	auto add_layer = [&layer_v, &layer_spare]() {
+		if(layer_spare.empty()) {
+			layer_v.push_back({});
+		} else {
+			layer_v.push_back(std::move(layer_spare.back()));
+			layer_spare.pop_back();
+		}
+	};
 	for(int i=0; i<topo.size(); i++) {
 		int vi = topo[i];
 		auto *edge = fg.add_edge(v_in(vi), v_out(vi));
@@ -58,31 +210,34 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
 		edge = fg.add_edge(v_out(vi), fg.sink);
 		edge->flow = 1;
 		// Sparsify
-		std::vector<int> sparsify(paths, -1);
 		for(auto u:g.edge_in[vi]) {
-			sparsify[pathid[u]] = std::max(sparsify[pathid[u]], topo_idx[u]);
+			used_path.update(pathid[u], topo_idx[u]);
 		}
-		for(auto u:sparsify) {
-			if(u == -1)
-				continue;
+		used_path.drain(paths, [&fg, &topo, &v_out, &v_in, vi](int u) {
 			fg.add_edge(v_out(topo[u]), v_in(vi));
+		});
+		// Find a dec path, q[g] is a queue of layer g (popped up to q_head[g])
+		if(q.size() < layer_v.size()) {
+			q.resize(layer_v.size());
+			q_head.resize(layer_v.size());
 		}
-		// Find a dec path
-		std::vector<std::queue<int>> q(layer_v.size());
-		q[q.size()-1].push(v_in(vi));
-		std::vector<int> visited_v;
+		for(int g=0; g<layer_v.size(); g++) {
+			q[g].clear();
+			q_head[g] = 0;
+		}
+		q[layer_v.size()-1].push_back(v_in(vi));
+		visited_v.clear();
 		visited[fg.source] = {1, nullptr};
 		visited[v_in(vi)] = {fg.source, edge2};
-		std::vector<int> visited_reset;
+		visited_reset.clear();
 		visited_reset.push_back(v_in(vi));
 		layer[v_in(vi)] = std::numeric_limits<int>::max();
 		layer[v_out(vi)] = std::numeric_limits<int>::max();
 		bool path_found = false;
 		int lowest_lr = std::numeric_limits<int>::max();
-		for(int g=q.size()-1; g>=0; g--) {
-			while(!q[g].empty() && !path_found) {
-				int s = q[g].front();
-				q[g].pop();
+		for(int g=layer_v.size()-1; g>=0; g--) {
+			while(q_head[g] < q[g].size() && !path_found) {
+				int s = q[g][q_head[g]++];
 				if(s == fg.sink)
 					continue;
 				lowest_lr = std::min(lowest_lr, layer[s]);
@@ -97,19 +252,25 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
 						path_found = true;
 						break;
 					}
-					q[layer[u.first]].push(u.first);
+					q[layer[u.first]].push_back(u.first);
 				}
 				for(auto u:fg.edge_in[s]) {
 					if(visited[u.first].first)
 						continue;
 					visited[u.first] = {-s, u.second};
 					visited_reset.push_back(u.first);
-					q[layer[u.first]].push(u.first);
+					q[layer[u.first]].push_back(u.first);
 				}
 			}
 		}
+		cancel_point(visited_v.size());
+		stats.visited += visited_v.size();
+		stats.layers += layer_v.size();
+		stats.max_layers = std::max(stats.max_layers, (int) layer_v.size());
 		if(!path_found) {
-			pathids[vi].push_back(paths);
+			if(paths == P::max_paths)
+				return nullptr;
+			P::add(pathids[vi], paths);
 			pathid[vi] = paths;
 			paths++;
 			path_ends.push_back(v_out(vi));
@@ -132,18 +293,18 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
 			visited[u] = {0, nullptr};
 		// We can assume that a path was found
 		// Update path ids
-		std::vector<int> used_path(paths);
+		used_path.clear_used(paths);
 		if(path_found){
 			if(!path_found)
 				std::cout << lowest_lr << std::endl;
-			std::vector<int> path_s_v_reset;
+			path_s_v_reset.clear();
 			auto s2 = [&fg, &layer, &v_out, &vi,&v_r, &path_ends, &path_s_v, &path_s_v_reset, &new_paths, &pathid, &pathids](int s, int pid, auto fs) {
 				if(s == fg.sink)
 					return;
 				if(s%2 == 0) {
 					// only add paths if is v_out node
 					pathid[v_r(s)] = pid;
-					new_paths[v_r(s)].push_back(pid);
+					P::add(new_paths[v_r(s)], pid);
 				}
 				if(path_s_v[s].first == -1) {
 					path_s_v[s].second = fg.edge_out[s].begin();
@@ -160,7 +321,7 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
 				}
 				fs(path_s_v[s].second->first, pid, fs);
 			};
-			std::vector<int> visited2_reset;
+			visited2_reset.clear();
 			auto s1 = [&fg, &s2, &new_paths, &used_path, &v_r, &v_out, &path_ends, &pathids, &visited2, &visited2_reset, &layer, &lowest_lr](int s, auto fs)  {
 				if(visited2[s] || layer[s] < lowest_lr || s == fg.sink || s == fg.source)
 					return;
@@ -170,15 +331,13 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
 					fs(u.first, fs);
 				}
 				// s2 is called in topological order
-				for(auto &u:pathids[v_r(s)]) {
-					if(used_path[u])
-						continue;
-					used_path[u] = 1;
-					s2(s, u, s2);
-				}
+				P::for_each(pathids[v_r(s)], [&used_path, &s2, s](int u) {
+					if(used_path.use(u))
+						s2(s, u, s2);
+				});
 				if(s%2==0) {
-					pathids[v_r(s)] = new_paths[v_r(s)];
-					new_paths[v_r(s)].clear();
+					std::swap(pathids[v_r(s)], new_paths[v_r(s)]);
+					P::clear(new_paths[v_r(s)]);
 				}
 			};
 			s1(v_in(vi), s1);
@@ -199,7 +358,7 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
 			lowest_lr = 0;
 			if((unsigned long) lowest_lr+1 == layer_v.size()) {
 				// top lr visited create new layer for v_out
-				layer_v.push_back({});
+				add_layer();
 			}
 			layer[v_in(vi)] = lowest_lr;
 			layer_v[lowest_lr].push_back(v_in(vi));
@@ -209,19 +368,14 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
 		}
 		if((unsigned long) lowest_lr+1 == layer_v.size()) {
 			// top lr visited create new layer for v_out
-			layer_v.push_back({});
+			add_layer();
 		}
 		for(auto u:visited_v) {
 			if(layer[u] != lowest_lr)
 				layer[u] = -1;
 		}
 		for(int g=lowest_lr+1; g<layer_v.size(); g++) {
-			std::vector<int> v;
-			for(auto u:layer_v[g]) {
-				if(layer[u] == g)
-					v.push_back(u);
-			}
-			layer_v[g] = v;
+			layer_v[g].erase(std::remove_if(layer_v[g].begin(), layer_v[g].end(), [&layer, g](int u){return layer[u] != g;}), layer_v[g].end());
 		}
 		for(auto u:visited_v) {
 			if(v_r(u) == vi)
@@ -244,6 +398,7 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
 		}
 		if(should_merge && lowest_lr > 0) {
 			// merge l+1 to l ...
+			stats.merges++;
 			for(int g=lowest_lr; g<layer_v.size(); g++) {
 				for(auto u:layer_v[g]) {
 					layer[u] = g-1;
@@ -251,54 +406,134 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
 				}
 				layer_v[g].clear();
 			}
+			layer_spare.push_back(std::move(layer_v.back()));
 			layer_v.pop_back();
 		}
 	}
 	return fgo;
 }
 
-std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2(Graph &g) {
-	std::vector<int> topo;
-	topo.reserve(g.n);
-	// Topo order O(n+m) OK
-	{
-		std::vector<bool> visited(g.n+1);
-		auto s1 = [&topo, &g, &visited](int s, auto dfs) {
-			if(visited[s])
-				return;
-			visited[s] = 1;
-			for(auto &u:g.edge_in[s]) {
-				dfs(u, dfs);
-			}
-			topo.push_back(s);
-		};
-		for(int i=1; i<=g.n; i++)
-			s1(i, s1);
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g) {
+	pflow_stats stats;
+	return pflowk3_paths<pathset_vector>(g, topo_order::dfs, stats);
+}
+
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3_ordered(Graph &g, topo_order order, pflow_stats *stats) {
+	pflow_stats st;
+	if(order == topo_order::reverse) {
+		Graph rg(g);
+		std::swap(rg.edge_in, rg.edge_out);
+		auto fgo = pflowk3_paths<pathset_vector>(rg, topo_order::dfs, st);
+		if(stats)
+			*stats = st;
+		return reverse_network(*fgo);
 	}
-	std::vector<int> topo_idx(g.n+1);
-	for(int i=0; i<topo.size(); i++) {
-		topo_idx[topo[i]] = i;
+	auto fgo = pflowk3_paths<pathset_vector>(g, order, st);
+	if(stats)
+		*stats = st;
+	return fgo;
+}
+
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3_bitset(Graph &g) {
+	pflow_stats stats;
+	auto fgo = pflowk3_paths<pathset_word>(g, topo_order::dfs, stats);
+	if(!fgo)
+		fgo = pflowk3_paths<pathset_vector>(g, topo_order::dfs, stats);
+	return fgo;
+}
+
+// State of pflowk2 after a prefix of a topological order. The network grows with the vertices, when it runs out
+// of room the source and sink are moved past the new vertices (O(n) for every doubling)
+struct pflowk2_state {
+	int n = 0, cap = 0;
+	std::unique_ptr<Flowgraph<Edge::Minflow>> fgo = std::make_unique<Flowgraph<Edge::Minflow>>(2, 1, 2);
+	std::vector<int> topo, topo_idx;
+	std::vector<int> backlink, backlink_id, newlink, backlink_first;
+	int backlink_cnt = 0; // every vertex without a dec path starts a path, this is the width of the prefix
+	std::vector<int> layer; // layer of node x
+	std::vector<std::vector<int>> layer_v = std::vector<std::vector<int>>(2);
+	std::vector<std::pair<int, std::vector<std::pair<int, Edge::Minflow*>>::iterator>> path_s_v;
+	std::vector<bool> visited2;
+	std::vector<std::pair<int, Edge::Minflow*>> visited;
+	// Scratch buffers reused by every vertex, nothing below allocates per vertex once they have grown
+	std::vector<int> sparsify;
+	std::vector<std::vector<int>> q;
+	std::vector<int> q_head;
+	std::vector<int> visited_v, visited_reset, path_s_v_reset, visited2_reset;
+	std::vector<std::pair<int,int>> vp1, vp2, qq;
+	std::vector<std::vector<int>> layer_spare; // emptied layers keep their capacity
+	pflow_stats stats;
+
+	pflowk2_state(int vertices) {
+		reserve(vertices);
 	}
-	auto v_in = [](int v){return v*2-1;};
-	auto v_out = [](int v){return v*2;};
-	auto v_r = [](int v){return (v+1)/2;}; // fg -> original graph
-	auto fgo = std::make_unique<Flowgraph<Edge::Minflow>>(g.n*2+2, g.n*2+1, g.n*2+2);
-	auto &fg = *fgo;
-	std::vector<int> backlink(g.n+1);
-	std::vector<int> backlink_id(g.n+1);
-	int backlink_cnt = 0;
-	std::vector<int> newlink(g.n+1);
-	std::vector<int> backlink_first(g.n+1);
-	std::vector<int> layer(fg.n+1); // layer of node x
-	std::vector<std::vector<int>> layer_v(2);
-	layer[fg.source] = std::numeric_limits<int>::min();
-	layer[fg.sink] = std::numeric_limits<int>::max();
-	std::vector<std::pair<int, std::vector<std::pair<int, Edge::Minflow*>>::iterator>> path_s_v(fg.n+1, {-1, {}});
-	std::vector<bool> visited2(fg.n+2); 
-	std::vector<std::vector<int>> new_paths(g.n+1);
-	std::vector<std::pair<int, Edge::Minflow*>> visited(fg.n+1); 
-	for(int i=0; i<topo.size(); i++) {
-		const int vi = topo[i];
+
+	void reserve(int vertices) {
+		if(vertices <= cap)
+			return;
+		cap = std::max(vertices, 2*cap);
+		auto &fg = *fgo;
+		const int source = 2*cap+1, sink = 2*cap+2;
+		fg.edge_in.resize(2*cap+3);
+		fg.edge_out.resize(2*cap+3);
+		// source->v_in is the first in-edge of v_in and v_out->sink the first out-edge of v_out
+		for(auto &[u,e]:fg.edge_out[fg.source])
+			fg.edge_in[u].front().first = source;
+		for(auto &[u,e]:fg.edge_in[fg.sink])
+			fg.edge_out[u].front().first = sink;
+		std::swap(fg.edge_out[source], fg.edge_out[fg.source]);
+		std::swap(fg.edge_in[sink], fg.edge_in[fg.sink]);
+		topo_idx.resize(cap+1);
+		backlink.resize(cap+1);
+		backlink_id.resize(cap+1);
+		newlink.resize(cap+1);
+		backlink_first.resize(cap+1);
+		sparsify.resize(cap, -1);
+		layer.resize(2*cap+3);
+		path_s_v.resize(2*cap+3, {-1, {}});
+		visited2.resize(2*cap+4);
+		visited.resize(2*cap+3);
+		visited[fg.source] = {0, nullptr};
+		layer[source] = std::numeric_limits<int>::min();
+		layer[sink] = std::numeric_limits<int>::max();
+		fg.n = 2*cap+2;
+		fg.source = source;
+		fg.sink = sink;
+	}
+
+	void add_layer() {
+		if(layer_spare.empty()) {
+			layer_v.push_back({});
+		} else {
+			layer_v.push_back(std::move(layer_spare.back()));
+			layer_spare.pop_back();
+		}
+	}
+
+	// Appends vi, whose in-neighbours have all been added
+	void add(int vi, const std::vector<int> &in) {
+		assert(vi <= cap);
+		auto &fg = *fgo;
+		auto v_in = [](int v){return v*2-1;};
+		auto v_out = [](int v){return v*2;};
+		auto v_r = [](int v){return (v+1)/2;}; // fg -> original graph
+		auto &layer = this->layer;
+		auto &layer_v = this->layer_v;
+		auto &backlink = this->backlink;
+		auto &backlink_id = this->backlink_id;
+		auto &backlink_first = this->backlink_first;
+		auto &newlink = this->newlink;
+		auto &path_s_v = this->path_s_v;
+		auto &path_s_v_reset = this->path_s_v_reset;
+		auto &visited2 = this->visited2;
+		auto &visited2_reset = this->visited2_reset;
+		auto &vp1 = this->vp1;
+		auto &vp2 = this->vp2;
+		// Polled before vi changes anything, weighted by the nodes the search of the previous vertex visited, so a
+		// cancelled add leaves the state of the vertices before
+		cancel_point(visited_v.size());
+		topo_idx[vi] = n++;
+		topo.push_back(vi);
 		auto *edge = fg.add_edge(v_in(vi), v_out(vi));
 		edge->demand = 1;
 		edge->flow = 1;
@@ -307,32 +542,38 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2(Graph &g) {
 		edge = fg.add_edge(fg.source, v_in(vi));
 		edge->flow = 1;
 		// Sparsify
-		std::vector<int> sparsify(backlink_cnt, -1);
-		for(auto &u:g.edge_in[vi]) {
+		for(auto &u:in) {
 			auto blid = backlink_id[backlink[u]];
 			sparsify[blid] = std::max(sparsify[blid], topo_idx[u]);
 		}
-		for(auto u:sparsify) {
-			if(u == -1)
+		for(int b=0; b<backlink_cnt; b++) {
+			if(sparsify[b] == -1)
 				continue;
-			fg.add_edge(v_out(topo[u]), v_in(vi));
+			fg.add_edge(v_out(topo[sparsify[b]]), v_in(vi));
+			sparsify[b] = -1;
 		}
-		// Find a dec path
-		std::vector<std::queue<int>> q(layer_v.size());
-		q[q.size()-1].push(v_in(vi));
-		std::vector<int> visited_v;
+		// Find a dec path, q[g] is a queue of layer g (popped up to q_head[g])
+		if(q.size() < layer_v.size()) {
+			q.resize(layer_v.size());
+			q_head.resize(layer_v.size());
+		}
+		for(int g=0; g<layer_v.size(); g++) {
+			q[g].clear();
+			q_head[g] = 0;
+		}
+		q[layer_v.size()-1].push_back(v_in(vi));
+		visited_v.clear();
 		visited[fg.source] = {1, nullptr};
 		visited[v_in(vi)] = {fg.source, edge};
-		std::vector<int> visited_reset;
+		visited_reset.clear();
 		visited_reset.push_back(v_in(vi));
 		layer[v_in(vi)] = std::numeric_limits<int>::max();
 		layer[v_out(vi)] = std::numeric_limits<int>::max();
 		bool path_found = false;
 		int lowest_lr = std::numeric_limits<int>::max();
-		for(int g=q.size()-1; g>=0; g--) {
-			while(!q[g].empty() && !path_found) {
-				int s = q[g].front();
-				q[g].pop();
+		for(int g=layer_v.size()-1; g>=0; g--) {
+			while(q_head[g] < q[g].size() && !path_found) {
+				int s = q[g][q_head[g]++];
 				lowest_lr = g;
 				visited_v.push_back(s);
 				for(auto &u:fg.edge_out[s]) {
@@ -345,17 +586,20 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2(Graph &g) {
 						path_found = true;
 						break;
 					}
-					q[layer[u.first]].push(u.first);
+					q[layer[u.first]].push_back(u.first);
 				}
 				for(auto &u:fg.edge_in[s]) {
 					if(visited[u.first].first)
 						continue;
 					visited[u.first] = {-s, u.second};
 					visited_reset.push_back(u.first);
-					q[layer[u.first]].push(u.first);
+					q[layer[u.first]].push_back(u.first);
 				}
 			}
 		}
+		stats.visited += visited_v.size();
+		stats.layers += layer_v.size();
+		stats.max_layers = std::max(stats.max_layers, (int) layer_v.size());
 		if(path_found) {
 			int cur = fg.sink;
 			while(cur != fg.source) {
@@ -379,28 +623,23 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2(Graph &g) {
 		if(lowest_lr == std::numeric_limits<int>::max()) {
 			lowest_lr = 0;
 			if((unsigned long) lowest_lr+1 == layer_v.size()) {
-				layer_v.push_back({});
+				add_layer();
 			}
 			layer[v_in(vi)] = lowest_lr;
 			layer_v[lowest_lr].push_back(v_in(vi));
 			layer[v_out(vi)] = lowest_lr+1;
 			layer_v[lowest_lr+1].push_back(v_out(vi));
-			continue;
+			return;
 		}
 		if((unsigned long) lowest_lr+1 == layer_v.size()) {
-			layer_v.push_back({});
+			add_layer();
 		}
 		for(auto u:visited_v) {
 			if(layer[u] != lowest_lr)
 				layer[u] = -1;
 		}
 		for(int g=lowest_lr+1; g<layer_v.size(); g++) {
-			std::vector<int> v;
-			for(auto u:layer_v[g]) {
-				if(layer[u] == g)
-					v.push_back(u);
-			}
-			layer_v[g] = v;
+			layer_v[g].erase(std::remove_if(layer_v[g].begin(), layer_v[g].end(), [&layer, g](int u){return layer[u] != g;}), layer_v[g].end());
 		}
 		for(auto u:visited_v) {
 			if(v_r(u) == vi)
@@ -415,9 +654,9 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2(Graph &g) {
 		layer_v[lowest_lr+1].push_back(v_out(vi));
 		bool should_merge = true;
 		{
-			std::vector<int> path_s_v_reset;
-			std::vector<std::pair<int,int>> vp1;
-			std::vector<std::pair<int,int>> vp2;
+			path_s_v_reset.clear();
+			vp1.clear();
+			vp2.clear();
 			auto s2 = [&backlink, &newlink,&vi, &vp1, &vp2, &lowest_lr,&backlink_first, &fg, &layer, &v_out,&v_in, &v_r, &path_s_v, &path_s_v_reset](int s, int bli, auto fs)->int {
 				if(s == fg.sink)
 					return -1;
@@ -446,7 +685,7 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2(Graph &g) {
 					newlink[v_r(s)] = nwl;
 				return nwl;
 			};
-			std::vector<int> visited2_reset;
+			visited2_reset.clear();
 			auto s1 = [&fg, &s2,&should_merge, &lowest_lr,&backlink_first, &v_in,  &v_r, &v_out, &visited2, &visited2_reset, &layer](int s, auto fs)  {
 				if(visited2[s] || layer[s] < lowest_lr || s == fg.sink || s == fg.source)
 					return;
@@ -497,8 +736,9 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2(Graph &g) {
 			}
 		}
 		if(should_merge && lowest_lr > 0) {
+			stats.merges++;
 			for(int g=lowest_lr; g<layer_v.size(); g++) {
-				std::vector<std::pair<int,int>> qq;
+				qq.clear();
 				if(g == lowest_lr) {
 					for(auto u:layer_v[g]) {
 						if(u == v_in(v_r(u)) && layer[v_in(backlink[v_r(u)])] == lowest_lr-1) {
@@ -514,8 +754,265 @@ std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2(Graph &g) {
 				}
 				layer_v[g].clear();
 			}
+			layer_spare.push_back(std::move(layer_v.back()));
 			layer_v.pop_back();
 		}
 	}
+};
+
+// Adds the vertices of g to st in a topological order while the prefix needs at most max_width paths, returns the
+// number of vertices added, the order is st.topo followed by the returned rest
+static int pflowk2_sweep(Graph &g, pflowk2_state &st, int max_width, std::vector<int> &topo, topo_order order=topo_order::dfs) {
+	topo = topological_order(g, order);
+	int i = 0;
+	for(; i<topo.size() && st.backlink_cnt <= max_width; i++)
+		st.add(topo[i], g.edge_in[topo[i]]);
+	return i;
+}
+
+// Paths of the flow of st in its topological order, in one pass without changing the flow. Every unit of flow is a
+// path id, the units entering v_in(v) from other vertices are written to arrival[offset[v]..]
+static path_cover pflowk2_decompose(pflowk2_state &st) {
+	auto &fg = *st.fgo;
+	auto v_in = [](int v){return v*2-1;};
+	auto v_out = [](int v){return v*2;};
+	auto v_r = [](int v){return (v+1)/2;}; // fg -> original graph
+	// v_in->v_out is the first out-edge of v_in and source->v_in the first in-edge
+	auto through = [&fg, &v_in](int v){return fg.edge_out[v_in(v)][0].second->flow;};
+	auto started = [&fg, &v_in](int v){return fg.edge_in[v_in(v)][0].second->flow;};
+	std::vector<int> offset(st.cap+1), arrival;
+	int total = 0;
+	for(auto v:st.topo) {
+		offset[v] = total;
+		total += through(v) - started(v);
+	}
+	arrival.resize(total);
+	path_cover cover;
+	std::vector<int> here;
+	for(auto v:st.topo) {
+		cancel_point();
+		// the in-neighbours of v advanced offset[v] past the units they wrote
+		int in = through(v)-started(v);
+		here.assign(arrival.begin()+offset[v]-in, arrival.begin()+offset[v]);
+		for(int p=0; p<started(v); p++) {
+			here.push_back(cover.size());
+			cover.push_back({});
+		}
+		for(auto p:here)
+			cover[p].push_back(v);
+		int k = 0;
+		for(auto &[u,e]:fg.edge_out[v_out(v)]) {
+			if(u == fg.sink) {
+				k += e->flow;
+				continue;
+			}
+			for(int f=0; f<e->flow; f++)
+				arrival[offset[v_r(u)]++] = here[k++];
+		}
+	}
+	return cover;
+}
+
+// Stops the sweep once the prefix needs more than max_width paths, see pflowk2_adaptive
+static std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2_run(Graph &g, int max_width, int *fallback_at, maxflow_solver_fn<int>::type &solver) {
+	auto v_in = [](int v){return v*2-1;};
+	auto v_out = [](int v){return v*2;};
+	pflowk2_state st(g.n);
+	std::vector<int> topo;
+	int i = pflowk2_sweep(g, st, max_width, topo);
+	if(fallback_at)
+		*fallback_at = i < topo.size() ? i : -1;
+	if(i == topo.size())
+		return std::move(st.fgo);
+	auto &fg = *st.fgo;
+	// The prefix keeps its minimum flow on the sparsified edges (same reachability). The rest gets all of its
+	// in-edges and a greedy flow extending a path that ends at an in-neighbour, max flow then removes the surplus.
+	for(; i<topo.size(); i++) {
+		const int vi = topo[i];
+		auto *edge = fg.add_edge(v_in(vi), v_out(vi));
+		edge->demand = 1;
+		edge->flow = 1;
+		edge = fg.add_edge(v_out(vi), fg.sink);
+		edge->flow = 1;
+		auto *start = fg.add_edge(fg.source, v_in(vi));
+		start->flow = 1;
+		for(auto u:g.edge_in[vi]) {
+			edge = fg.add_edge(v_out(u), v_in(vi));
+			auto *end = fg.edge_out[v_out(u)].front().second; // v_out(u)->sink is added first
+			if(start->flow && end->flow) {
+				end->flow--;
+				start->flow--;
+				edge->flow++;
+			}
+		}
+	}
+	minflow_maxflow_reduction(fg, solver);
+	return std::move(st.fgo);
+}
+
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2(Graph &g) {
+	maxflow_solver_fn<int>::type none;
+	return pflowk2_run(g, std::numeric_limits<int>::max(), nullptr, none);
+}
+
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2_ordered(Graph &g, topo_order order, pflow_stats *stats) {
+	if(order == topo_order::reverse) {
+		Graph rg(g);
+		std::swap(rg.edge_in, rg.edge_out);
+		return reverse_network(*pflowk2_ordered(rg, topo_order::dfs, stats));
+	}
+	pflowk2_state st(g.n);
+	std::vector<int> topo;
+	pflowk2_sweep(g, st, std::numeric_limits<int>::max(), topo, order);
+	if(stats)
+		*stats = st.stats;
+	return std::move(st.fgo);
+}
+
+path_cover pflowk2_cover(Graph &g) {
+	pflowk2_state st(g.n);
+	std::vector<int> topo;
+	pflowk2_sweep(g, st, std::numeric_limits<int>::max(), topo);
+	return pflowk2_decompose(st);
+}
+
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2_adaptive(Graph &g, int max_width, int *fallback_at, maxflow_solver_fn<int>::type solver) {
+	return pflowk2_run(g, max_width, fallback_at, solver);
+}
+
+online_mpc::online_mpc():state(std::make_unique<pflowk2_state>(0)) {
+}
+
+online_mpc::~online_mpc() {
+}
+
+int online_mpc::add_vertex(const std::vector<int> &in_neighbours) {
+	int v = state->n+1;
+	for(auto u:in_neighbours)
+		assert(u >= 1 && u < v);
+	state->reserve(v);
+	state->add(v, in_neighbours);
+	return v;
+}
+
+int online_mpc::size() {
+	return state->n;
+}
+
+int online_mpc::width() {
+	return state->backlink_cnt;
+}
+
+Flowgraph<Edge::Minflow>& online_mpc::network() {
+	return *state->fgo;
+}
+
+path_cover online_mpc::current_cover() {
+	return pflowk2_decompose(*state);
+}
+
+antichain online_mpc::current_antichain() {
+	return maxantichain_from_minflow(*state->fgo);
+}
+
+// Every edge (a,b) becomes a->x->b, an MPC of the subdivided graph covers every edge and the only paths
+// without a subdivision vertex are the ones of isolated vertices, so dropping them leaves a minimum edge cover
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflow_edge_cover(Graph &g, std::function<std::unique_ptr<Flowgraph<Edge::Minflow>>(Graph&)> solver) {
+	int m = g.count_edges();
+	Graph sg(g.n+m);
+	int x = g.n;
+	for(int i=1; i<=g.n; i++) {
+		for(auto &u:g.edge_out[i]) {
+			x++;
+			sg.add_edge(i, x);
+			sg.add_edge(x, u);
+		}
+	}
+	auto sfgo = solver(sg);
+	auto &sfg = *sfgo;
+	auto v_in = [](int v){return v*2-1;};
+	auto v_out = [](int v){return v*2;};
+	auto v_r = [](int v){return (v+1)/2;}; // fg -> original graph
+	std::vector<int> through(sg.n+1), starts(sg.n+1), ends(sg.n+1);
+	for(auto &[u,e]:sfg.edge_out[sfg.source])
+		starts[v_r(u)] += e->flow;
+	for(auto &[u,e]:sfg.edge_in[sfg.sink])
+		ends[v_r(u)] += e->flow;
+	for(int i=1; i<=sg.n; i++)
+		for(auto &[u,e]:sfg.edge_out[v_in(i)])
+			through[i] += e->flow;
+
+	// Paths starting (ending) at x are extended to a (b)
+	auto fgo = naive_minflow_reduction_edges(g);
+	auto &fg = *fgo;
+	x = g.n;
+	for(int i=1; i<=g.n; i++) {
+		for(int j=0; j<g.edge_out[i].size(); j++) {
+			x++;
+			int u = g.edge_out[i][j];
+			fg.edge_out[v_out(i)][j].second->flow = through[x];
+			through[i] += starts[x];
+			starts[i] += starts[x];
+			through[u] += ends[x];
+			ends[u] += ends[x];
+		}
+	}
+	// naive_minflow_reduction_edges adds the edges of v_out(i) before v_out(i)->sink and source edges in order
+	for(int i=1; i<=g.n; i++) {
+		if(g.edge_in[i].empty() && g.edge_out[i].empty()) {
+			through[i] = starts[i] = ends[i] = 0;
+		}
+		fg.edge_out[v_in(i)][0].second->flow = through[i];
+		fg.edge_out[fg.source][i-1].second->flow = starts[i];
+		fg.edge_out[v_out(i)].back().second->flow = ends[i];
+	}
+	assert(is_valid_minflow(fg));
 	return fgo;
 }
+
+// Every path of the unweighted MPC carries the largest weight on it, which gives a feasible flow of at most
+// k*max(w), the surplus is then removed by max-flow on the O(kn) edges kept by pflowk2
+template<typename T> std::unique_ptr<Flowgraph<Edge::Minflow_t<T>>> pflowk2_weighted(Graph &g, std::function<T(int)> node_weight) {
+	auto fgo = pflowk2(g);
+	auto &fg = *fgo;
+	auto v_r = [](int v){return (v+1)/2;}; // fg -> original graph
+	// Same edges in the same order, wfg.edge_out[i][j] is fg.edge_out[i][j]
+	auto wfgo = std::make_unique<Flowgraph<Edge::Minflow_t<T>>>(fg.n, fg.source, fg.sink);
+	auto &wfg = *wfgo;
+	for(int i=1; i<=fg.n; i++) {
+		for(auto &[u,e]:fg.edge_out[i]) {
+			auto *e2 = wfg.add_edge(i, u);
+			if(e->demand > 0)
+				e2->demand = node_weight(v_r(i));
+		}
+	}
+	std::vector<int> edge_ptr(fg.n+1);
+	std::vector<Edge::Minflow_t<T>*> path;
+	while(true) {
+		path.clear();
+		int cur = fg.source;
+		T c = 0;
+		while(cur != fg.sink) {
+			while(edge_ptr[cur] < fg.edge_out[cur].size() && fg.edge_out[cur][edge_ptr[cur]].second->flow == 0)
+				edge_ptr[cur]++;
+			if(edge_ptr[cur] == fg.edge_out[cur].size())
+				break;
+			auto &[u,e] = fg.edge_out[cur][edge_ptr[cur]];
+			e->flow--;
+			auto *e2 = wfg.edge_out[cur][edge_ptr[cur]].second;
+			c = std::max(c, e2->demand);
+			path.push_back(e2);
+			cur = u;
+		}
+		if(path.empty())
+			break;
+		assert(cur == fg.sink);
+		for(auto e:path)
+			e->flow += c;
+	}
+	minflow_maxflow_reduction(wfg, maxflow_solve_edmonds_karp_DMOD<T>);
+	return wfgo;
+}
+
+template std::unique_ptr<Flowgraph<Edge::Minflow_t<int>>> pflowk2_weighted<int>(Graph&, std::function<int(int)>);
+template std::unique_ptr<Flowgraph<Edge::Minflow_t<long long>>> pflowk2_weighted<long long>(Graph&, std::function<long long(int)>);
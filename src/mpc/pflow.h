@@ -1,6 +1,66 @@
 #pragma once
 #include "graph.h"
 #include "naive.h"
+#include "antichain.h"
+#include <string>
+
+// Order in which pflowk2 and pflowk3 add the vertices, the flow is minimum for every order but the sparsified
+// network, the number of layers and the work of the dec path searches differ
+enum class topo_order {
+	dfs, // post-order of a DFS over the in-edges (default)
+	kahn, // Kahn's algorithm with a FIFO queue
+	longest_path, // by the number of vertices on the longest path ending at the vertex
+	reverse // solves the reversed graph in DFS order, the flow is reversed back
+};
+extern const std::vector<std::pair<topo_order, std::string>> topo_orders;
+// Longest path layering of g: level[v] is the number of edges of a longest path ending at v, 0 for the sources (level[0]
+// is unused). kahn gets the order in which Kahn's algorithm removes the vertices, O(n+m)
+std::vector<int> longest_path_levels(Graph &g, std::vector<int> *kahn=nullptr);
+// A topological order of g, reverse gives the DFS order of the reversed graph
+std::vector<int> topological_order(Graph &g, topo_order order);
+// Counters of one run of pflowk2 or pflowk3
+struct pflow_stats {
+	long long visited = 0; // nodes popped by the dec path searches
+	long long layers = 0; // number of layers summed over the vertices when they are added
+	int max_layers = 0;
+	long long merges = 0; // merges of two layers
+};
 
 std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3(Graph &g);
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3_ordered(Graph &g, topo_order order, pflow_stats *stats=nullptr);
+// pflowk3 with the path ids of each vertex as a bitmask, restarts with pflowk3 if the width exceeds 64
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk3_bitset(Graph &g);
 std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2(Graph &g);
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2_ordered(Graph &g, topo_order order, pflow_stats *stats=nullptr);
+// MPC of pflowk2 without returning the network, the paths are read off the flow in one topological pass
+path_cover pflowk2_cover(Graph &g);
+// pflowk2 until the processed prefix needs more than max_width paths, then the flow of the prefix is extended
+// greedily to the rest of the graph and minimized by solver. fallback_at gets the topological index of the switch or -1
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflowk2_adaptive(Graph &g, int max_width, int *fallback_at=nullptr, maxflow_solver_fn<int>::type solver=maxflow_solve_edmonds_karp_DMOD<int>);
+// Minimum flow with demand node_weight(v) on v_in(v)->v_out(v), on the sparsified network of pflowk2. Not bounded
+// by the width alone: pflowk2 and the replay of its k paths are followed by maxflow_solve_edmonds_karp_DMOD (Dinic's
+// level graph and blocking flows) on the O(kn) edges. Every phase and every augmenting path costs O(kn) and every path
+// removes at least 1 of the initial k*W flow, W the largest weight, for O(k^2 n W) time overall
+template<typename T> std::unique_ptr<Flowgraph<Edge::Minflow_t<T>>> pflowk2_weighted(Graph &g, std::function<T(int)> node_weight);
+
+// Minimum flow of naive_minflow_reduction_edges(g) computed by solving the vertex version on g with every edge subdivided
+std::unique_ptr<Flowgraph<Edge::Minflow>> pflow_edge_cover(Graph &g, std::function<std::unique_ptr<Flowgraph<Edge::Minflow>>(Graph&)> solver=pflowk2);
+
+struct pflowk2_state;
+// Minimum path cover of a DAG given one vertex at a time in a topological order, kept by pflowk2 in amortized
+// O(k^2) per vertex plus its in-degree. Vertices are numbered 1, 2, ... in the order they are added
+struct online_mpc {
+	std::unique_ptr<pflowk2_state> state;
+
+	online_mpc();
+	~online_mpc();
+	// Every in-neighbour must already be added, returns the number of the new vertex. A cancelled call (cancel.h)
+	// adds nothing and the cover stays usable
+	int add_vertex(const std::vector<int> &in_neighbours);
+	int size();
+	int width();
+	// Minimum flow of the vertices added so far, on the sparsified edges of pflowk2
+	Flowgraph<Edge::Minflow>& network();
+	path_cover current_cover();
+	antichain current_antichain();
+};
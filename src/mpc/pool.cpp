@@ -0,0 +1,221 @@
+#include "pool.h"
+#include "cancel.h"
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+struct pool_task {
+	std::function<void()> f;
+	task_group *group;
+	cancel_token *token;
+};
+
+// Deque per thread, the owner pushes and pops at the back and the others steal from the front. Threads outside the
+// pool share queue 0
+struct pool_queue {
+	std::mutex m;
+	std::deque<pool_task*> tasks;
+};
+
+struct pool_state {
+	std::mutex configure;
+	std::atomic<bool> started{false}, stop{false};
+	int threads = 1;
+	size_t stack = 8<<20;
+	std::vector<std::unique_ptr<pool_queue>> queues;
+	std::vector<pthread_t> workers;
+	std::atomic<int> queued{0};
+	std::mutex sleep;
+	std::condition_variable wake;
+};
+static pool_state &pool = *new pool_state(); // never destroyed, the workers still sleep on it at exit
+
+static thread_local int pool_worker = 0; // queue of this thread
+
+static void execute(pool_task *t) {
+	{
+		cancel_scope scope(t->token);
+		try {
+			t->f();
+		} catch(...) {
+			std::lock_guard<std::mutex> lock(t->group->m);
+			if(!t->group->error)
+				t->group->error = std::current_exception();
+		}
+	}
+	auto *group = t->group;
+	delete t;
+	if(group->pending.fetch_sub(1) == 1) { // the group may be gone once pending is 0, its waiter sleeps on wake
+		std::lock_guard<std::mutex> lock(pool.sleep);
+		pool.wake.notify_all();
+	}
+}
+
+// The newest task of queue own, else the oldest of another queue
+static pool_task* take(int own) {
+	{
+		auto &q = *pool.queues[own];
+		std::lock_guard<std::mutex> lock(q.m);
+		if(!q.tasks.empty()) {
+			auto *t = q.tasks.back();
+			q.tasks.pop_back();
+			pool.queued--;
+			return t;
+		}
+	}
+	for(int i=1; i<pool.queues.size(); i++) {
+		auto &q = *pool.queues[(own+i)%pool.queues.size()];
+		std::lock_guard<std::mutex> lock(q.m);
+		if(!q.tasks.empty()) {
+			auto *t = q.tasks.front();
+			q.tasks.pop_front();
+			pool.queued--;
+			return t;
+		}
+	}
+	return nullptr;
+}
+
+static void* worker(void *arg) {
+	pool_worker = (int) (size_t) arg;
+	while(!pool.stop) {
+		if(auto *t = take(pool_worker)) {
+			execute(t);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(pool.sleep);
+		pool.wake.wait(lock, []{return pool.stop || pool.queued > 0;});
+	}
+	return nullptr;
+}
+
+// Workers do not survive fork(), the child starts a new pool on first use
+static void forget_workers() {
+	pool.workers.clear();
+	pool.queues.clear();
+	pool.queued = 0;
+	pool.started = false;
+}
+
+static void stop_workers() {
+	{
+		std::lock_guard<std::mutex> lock(pool.sleep);
+		pool.stop = true;
+	}
+	pool.wake.notify_all();
+	for(auto &t:pool.workers)
+		pthread_join(t, nullptr);
+	pool.workers.clear();
+	pool.stop = false;
+}
+
+// Queue 0 and a queue per worker
+static void start_workers(int threads, size_t stack) {
+	static bool at_fork = pthread_atfork(nullptr, nullptr, forget_workers) == 0;
+	assert(at_fork);
+	pool.threads = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+	pool.stack = stack;
+	pool.queues.clear();
+	for(int i=0; i<pool.threads; i++)
+		pool.queues.push_back(std::make_unique<pool_queue>());
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, pool.stack);
+	pool.workers.resize(pool.threads-1);
+	int started = 0;
+	while(started < pool.workers.size() && pthread_create(&pool.workers[started], &attr, worker, (void*) (size_t) (started+1)) == 0)
+		started++;
+	pthread_attr_destroy(&attr);
+	// Fewer workers if the threads or their stacks can not be had, their queues stay empty
+	pool.workers.resize(started);
+	pool.threads = started+1;
+	pool.started = true;
+}
+
+static void ensure_started() {
+	if(pool.started)
+		return;
+	std::lock_guard<std::mutex> lock(pool.configure);
+	if(!pool.started)
+		start_workers(0, pool.stack);
+}
+
+void pool_configure(int threads, size_t stack_bytes) {
+	std::lock_guard<std::mutex> lock(pool.configure);
+	if(pool.started)
+		stop_workers();
+	start_workers(threads, stack_bytes);
+}
+
+int pool_threads() {
+	ensure_started();
+	return pool.threads;
+}
+
+size_t pool_stack() {
+	ensure_started();
+	return pool.stack;
+}
+
+void task_group::run(std::function<void()> f) {
+	ensure_started();
+	pending++;
+	auto *t = new pool_task{std::move(f), this, cancel_current};
+	if(pool.threads == 1) {
+		execute(t);
+		return;
+	}
+	{
+		auto &q = *pool.queues[pool_worker];
+		std::lock_guard<std::mutex> lock(q.m);
+		q.tasks.push_back(t);
+	}
+	{
+		std::lock_guard<std::mutex> lock(pool.sleep);
+		pool.queued++;
+	}
+	pool.wake.notify_one();
+}
+
+// Runs queued tasks until the group is done, sleeping while there are none
+static void join(task_group &group) {
+	while(group.pending > 0) {
+		if(auto *t = take(pool_worker)) {
+			execute(t);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(pool.sleep);
+		pool.wake.wait(lock, [&group]{return group.pending == 0 || pool.queued > 0;});
+	}
+}
+
+void task_group::wait() {
+	join(*this);
+	if(error) {
+		auto e = error;
+		error = nullptr;
+		std::rethrow_exception(e);
+	}
+}
+
+task_group::~task_group() {
+	join(*this);
+}
+
+void parallel_for(int begin, int end, int grain, const std::function<void(int, int)> &f) {
+	grain = std::max(1, grain);
+	if(end-begin <= grain || pool_threads() == 1) {
+		if(begin < end)
+			f(begin, end);
+		return;
+	}
+	task_group tasks;
+	for(int lo=begin; lo<end; lo+=grain)
+		tasks.run([&f, lo, hi=std::min(end, lo+grain)]{f(lo, hi);});
+	tasks.wait();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+// Sets the threads of the task pool shared by the parallel parts of the library (the thread waiting for tasks is one
+// of them, 0 for the hardware threads) and the stack of its workers. Fewer threads are started if the system can not
+// create them, pool_threads() gives the number. Restarts the pool, no task may be running. The pool starts with the
+// hardware threads and 8 MB stacks on first use, and again in the child of a fork()
+void pool_configure(int threads, size_t stack_bytes=8<<20);
+int pool_threads();
+size_t pool_stack();
+
+// Tasks forked into the pool and joined by wait(). Tasks may fork and join groups of their own, a waiting thread runs
+// queued tasks (the newest of its own first, then the oldest of another thread) and sleeps while there are none. A
+// task runs under the cancel token of the thread that forked it, the first exception of a task is rethrown by wait()
+struct task_group {
+	std::atomic<int> pending{0};
+	std::exception_ptr error;
+	std::mutex m;
+
+	void run(std::function<void()> f);
+	void wait();
+	~task_group();
+};
+
+// f(lo, hi) over [begin, end) in chunks of at most grain, on the pool
+void parallel_for(int begin, int end, int grain, const std::function<void(int, int)> &f);
+
+// Scratch object of this thread, a worker keeps it between tasks and allocates it once
+template<typename T> T& thread_scratch() {
+	static thread_local T scratch;
+	return scratch;
+}
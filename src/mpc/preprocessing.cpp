@@ -124,6 +124,44 @@ path_cover recover_contract_pathcover(path_cover &pc, std::vector<std::vector<in
 	return np;
 }
 
+// O(n+m), every in-neighbour reaches the last in-neighbour on its path so reachability is preserved. Vertices
+// on several paths are only considered on the first one, the edges of pc are kept explicitly
+std::unique_ptr<Graph> sparsify_cover(Graph &gs, path_cover &pc) {
+	std::vector<std::pair<int,int>> on_path(gs.n+1, {-1, -1}); // (path, position)
+	std::vector<std::vector<int>> cover_pred(gs.n+1);
+	for(int i=0; i<pc.size(); i++) {
+		for(int j=0; j<pc[i].size(); j++) {
+			if(on_path[pc[i][j]].first == -1)
+				on_path[pc[i][j]] = {i, j};
+			if(j > 0)
+				cover_pred[pc[i][j]].push_back(pc[i][j-1]);
+		}
+	}
+	auto g = std::make_unique<Graph>(gs.n);
+	std::vector<int> last(pc.size(), -1), touched, added(gs.n+1);
+	for(int v=1; v<=gs.n; v++) {
+		for(auto u:gs.edge_in[v]) {
+			auto [p, pos] = on_path[u];
+			if(last[p] == -1)
+				touched.push_back(p);
+			last[p] = std::max(last[p], pos);
+		}
+		for(auto p:touched) {
+			g->add_edge(pc[p][last[p]], v);
+			added[pc[p][last[p]]] = v;
+			last[p] = -1;
+		}
+		touched.clear();
+		for(auto u:cover_pred[v]) {
+			if(added[u] != v) {
+				g->add_edge(u, v);
+				added[u] = v;
+			}
+		}
+	}
+	return g;
+}
+
 // O(n+m) 
 std::unique_ptr<Graph> sparsify_dfs_elegant(Graph &gs) {
 	std::vector<std::vector<int>> edge_out_topo_order(gs.n+1);
@@ -4,6 +4,8 @@
 #include <map>
 
 std::unique_ptr<Graph> sparsify_dfs_elegant(Graph &gs);
+// Keeps for each vertex only its last in-neighbour on each path of pc (a path cover of gs), O(k'n) edges
+std::unique_ptr<Graph> sparsify_cover(Graph &gs, path_cover &pc);
 
 struct contract_tree_recovery_data {
 	Graph g;
@@ -2,6 +2,8 @@
 #include <mpc/naive.h>
 #include <mpc/graph.h>
 #include <mpc/pflow.h>
+#include <mpc/cancel.h>
+#include <mpc/pool.h>
 
 // Check if there exists a path a->b by dfs O(|V|+|E|)
 bool naive_reach(int a, int b, Graph &g);
@@ -13,8 +15,11 @@ struct reachability_idx {
 	std::vector<std::vector<int>> l2r; 
 	reachability_idx(Graph &g, path_cover &pc) {
 		l2r.resize(g.n+1);
-		for(int i=1; i<=g.n; i++)
-			l2r[i].resize(pc.size());
+		// Zeroing the O(|V|k) rows is split over the pool, the propagation below depends on the order
+		parallel_for(1, g.n+1, 1024, [this, &pc](int lo, int hi) {
+			for(int i=lo; i<hi; i++)
+				l2r[i].resize(pc.size());
+		});
 		some_path.resize(g.n+1);
 		std::vector<int> topo, lvl(g.n+1);
 		std::vector<bool> visited(g.n+1);
@@ -57,6 +62,7 @@ struct reachability_idx {
 			}
 		}
 		for(auto &u:topo) {
+			cancel_point();
 			for(auto &v:rtopo_edges[u]) {
 				auto &p = some_path[v];
 				if(l2r[u][p] >= l2r[v][p])
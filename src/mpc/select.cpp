@@ -0,0 +1,59 @@
+#include "select.h"
+#include "pflow.h"
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+graph_features compute_features(Graph &g) {
+	auto start = std::chrono::steady_clock::now();
+	graph_features f;
+	f.n = g.n;
+	f.m = g.count_edges();
+	f.avg_degree = g.n ? 1.0*f.m/g.n : 0;
+	int in_le1 = 0, out_le1 = 0;
+	for(int i=1; i<=g.n; i++) {
+		f.max_in = std::max<int>(f.max_in, g.edge_in[i].size());
+		f.max_out = std::max<int>(f.max_out, g.edge_out[i].size());
+		in_le1 += g.edge_in[i].size() <= 1;
+		out_le1 += g.edge_out[i].size() <= 1;
+	}
+	f.tree_likeness = g.n ? 1.0*std::max(in_le1, out_le1)/g.n : 1;
+	auto level = longest_path_levels(g);
+	std::vector<int> count(g.n+1);
+	for(int i=1; i<=g.n; i++) {
+		count[level[i]]++;
+		f.depth = std::max(f.depth, level[i]+1);
+	}
+	f.largest_level = *std::max_element(count.begin(), count.end());
+	f.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+	return f;
+}
+
+// Rows of the rule table, the first one that matches picks the choice
+struct selection_rule {
+	std::string name;
+	std::function<bool(graph_features&)> matches;
+	solver_choice choice;
+};
+
+// Calibrated with prog/bench/select on the generators of graph.h (n=20000, one thread). --contract_graph was the
+// fastest on in-forests (1.3-1.6x over multilevel), multilevel was 5-40x faster than pflowk2 on the other trees and
+// on wide sparse graphs (random_dag with m <= 3n, random_x_partite) and within noise of pflowk2 on dense or narrow
+// ones. pflowk3 and --sparsify_dfs were never clearly the fastest, so no row picks them
+static const std::vector<selection_rule> rules = {
+	{"in_forest", [](graph_features &f){return f.max_out <= 1;}, {"pflowk2", true, false, 0, ""}},
+	{"tree", [](graph_features &f){return f.tree_likeness >= 0.9;}, {"pflowk2", false, false, 1000, ""}},
+	{"wide_sparse", [](graph_features &f){return f.avg_degree <= 5 && f.largest_level*20 >= f.n;}, {"pflowk2", false, false, 1000, ""}},
+	{"default", [](graph_features &){return true;}, {"pflowk2", false, false, 0, ""}}};
+
+solver_choice choose_solver(graph_features &f) {
+	for(auto &r:rules) {
+		if(r.matches(f)) {
+			auto c = r.choice;
+			c.rule = r.name;
+			return c;
+		}
+	}
+	return {};
+}
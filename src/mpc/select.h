@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include "graph.h"
+
+// Cheap features of a graph for choose_solver
+struct graph_features {
+	int n = 0, m = 0;
+	double avg_degree = 0; // edges per vertex
+	int max_in = 0, max_out = 0;
+	int depth = 0; // levels of a longest path layering
+	int largest_level = 0; // an antichain, lower bound on the width
+	double tree_likeness = 0; // largest fraction of vertices with in-degree <= 1 or with out-degree <= 1
+	double ms = 0; // time to compute the features
+};
+graph_features compute_features(Graph &g);
+
+// Solver and preprocessing of exp for a graph, rule names the row of the rule table that picked it
+struct solver_choice {
+	std::string solver = "pflowk2";
+	bool contract_graph = false;
+	bool sparsify_dfs = false;
+	int multilevel = 0; // coarse_n of --multilevel, 0 solves the graph as a whole
+	std::string rule;
+};
+solver_choice choose_solver(graph_features &f);
@@ -0,0 +1,86 @@
+#include "window.h"
+#include <chrono>
+#include <algorithm>
+
+static auto v_in = [](int v){return v*2-1;};
+static auto v_out = [](int v){return v*2;};
+
+sliding_window_mpc::sliding_window_mpc(int W):W(W),fgo(std::make_unique<Flowgraph<Edge::Minflow>>(2*W+2, 2*W+1, 2*W+2)),dec(std::make_unique<minflow_decremental>(*fgo)) {
+	assert(W > 0);
+}
+
+static void record(window_latency &l, std::chrono::steady_clock::time_point start) {
+	l.last = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now()-start).count();
+	l.updates++;
+	l.total += l.last;
+	l.max = std::max(l.max, l.last);
+}
+
+int sliding_window_mpc::add_vertex(const std::vector<int> &in_neighbours) {
+	auto slot = [this](int v){return (v-1)%W+1;};
+	auto &fg = *fgo;
+	if(last-first()+1 == W) {
+		auto start = std::chrono::steady_clock::now();
+		int t = slot(first());
+		// t has no in-edges left, the paths ending at it disappear and the others start at its out-neighbours
+		for(auto &[u,e]:fg.edge_out[v_out(t)])
+			if(u == fg.sink)
+				paths -= e->flow;
+		dec->delete_vertex(t);
+		paths -= dec->repair();
+		if(first()%W == 0) {
+			fgo = std::make_unique<Flowgraph<Edge::Minflow>>(fg);
+			dec = std::make_unique<minflow_decremental>(*fgo);
+		}
+		record(expire_latency, start);
+	}
+	auto start = std::chrono::steady_clock::now();
+	auto &fg2 = *fgo;
+	int v = ++last, s = slot(v);
+	// A fresh slot has no edges, an expired one keeps only its source and sink edges
+	auto *edge = fg2.add_edge(v_in(s), v_out(s));
+	edge->demand = 1;
+	edge->flow = 1;
+	edge = fg2.edge_in[v_in(s)].empty() ? fg2.add_edge(fg2.source, v_in(s)) : fg2.edge_in[v_in(s)].front().second;
+	edge->flow = 1;
+	edge = fg2.edge_out[v_out(s)].empty() ? fg2.add_edge(v_out(s), fg2.sink) : fg2.edge_out[v_out(s)].front().second;
+	edge->flow = 1;
+	for(auto u:in_neighbours) {
+		assert(u < v);
+		if(u >= first())
+			fg2.add_edge(v_out(slot(u)), v_in(s));
+	}
+	paths++;
+	// Without v there was no decrementing path, a new one goes through v
+	dec->touched.push_back(v_in(s));
+	dec->touched.push_back(v_out(s));
+	paths -= dec->repair();
+	record(insert_latency, start);
+	return v;
+}
+
+int sliding_window_mpc::first() {
+	return std::max(1, last-W+1);
+}
+
+int sliding_window_mpc::width() {
+	return paths;
+}
+
+path_cover sliding_window_mpc::current_cover() {
+	Flowgraph<Edge::Minflow> fg(*fgo);
+	auto cover = minflow_reduction_path_recover_faster(fg);
+	int f = first();
+	for(auto &p:cover)
+		for(auto &u:p)
+			u = f+(u-(f-1)%W-1+W)%W;
+	return cover;
+}
+
+antichain sliding_window_mpc::current_antichain() {
+	auto ac = maxantichain_from_minflow(*fgo);
+	int f = first();
+	for(auto &u:ac)
+		u = f+(u-(f-1)%W-1+W)%W;
+	return ac;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "graph.h"
+#include "naive.h"
+#include "antichain.h"
+#include "decremental.h"
+
+// Time spent in one kind of update, in microseconds
+struct window_latency {
+	long long updates = 0;
+	double last = 0, total = 0, max = 0;
+};
+
+// MPC of the last W vertices of a stream of DAG vertices given in a topological order (numbered 1, 2, ...).
+// The network keeps a minimum flow on every edge inside the window. A new vertex starts its own path and the
+// decrementing path through it is searched (the pflowk2 step without layers, which deletions would invalidate),
+// the oldest vertex is a source of the window and expires through minflow_decremental. Vertex i uses the nodes
+// of slot (i-1)%W+1, every W expiries the network is copied to drop the deleted edges
+struct sliding_window_mpc {
+	int W;
+	int last = 0; // newest vertex
+	int paths = 0;
+	std::unique_ptr<Flowgraph<Edge::Minflow>> fgo;
+	std::unique_ptr<minflow_decremental> dec;
+	window_latency insert_latency, expire_latency;
+
+	sliding_window_mpc(int W);
+	// In-neighbours older than the window are ignored, the oldest vertex expires first if the window is full.
+	// Returns the number of the new vertex
+	int add_vertex(const std::vector<int> &in_neighbours);
+	int first(); // oldest vertex of the window
+	int width();
+	// Covers and antichains use the numbers of the stream
+	path_cover current_cover();
+	antichain current_antichain();
+};
@@ -5,9 +5,22 @@
 #include <mpc/reach.h>
 #include <mpc/antichain.cpp>
 #include <mpc/pflow.h>
+#include <mpc/minlen.h>
+#include <mpc/decremental.h>
+#include <mpc/window.h>
+#include <mpc/components.h>
+#include <mpc/multilevel.h>
+#include <mpc/anytime.h>
+#include <mpc/select.h>
+#include <mpc/cancel.h>
+#include <mpc/pool.h>
+#include <alloc.h>
 #include <fstream>
 #include <iostream>
 #include <vector>
+#include <numeric>
+#include <thread>
+#include <chrono>
 #include <gtest/gtest.h>
 #include <mpc/preprocessing.h>
 
@@ -71,9 +84,26 @@ void test_dfs_sparsify(Graph &g) {
 			ASSERT_TRUE(r1.reaches(i,j) == r2.reaches(i,j));
 }
 
+void test_cover_sparsify(Graph &g) {
+	auto gr = greedy_minflow_reduction(g);
+	auto gc = minflow_reduction_path_recover_faster(*gr);
+	auto sg = sparsify_cover(g, gc);
+	auto rg = naive_minflow_reduction(*sg);
+	lemon_ns(*rg);
+	auto cover = minflow_reduction_path_recover_faster(*rg);
+	auto pc = minflow_reduction_path_recover_faster(*pflowk2(g));
+	ASSERT_TRUE(cover.size() == pc.size() && is_valid_cover(cover, g));
+	ASSERT_TRUE(is_valid_cover(gc, *sg));
+	auto r1 = reachability_idx(g, pc);
+	auto r2 = reachability_idx(*sg, pc);
+	for(int i=1; i<=g.n; i++)
+		for(int j=1; j<=g.n; j++)
+			ASSERT_TRUE(r1.reaches(i,j) == r2.reaches(i,j));
+}
+
 void test_all(Graph &g) {
-	std::vector<std::function<void(Flowgraph<Edge::Minflow>&)>> mifsol = {lemon_cs, lemon_cs_minlen, lemon_ns, lemon_ns_minlen, lemon_cc, lemon_cc_minlen, lemon_caps, lemon_caps_minlen, naive_minflow_solve};
-	std::vector<std::function<void(Flowgraph<Edge::Maxflow>&)>> mafsol = {lemon_preflow, maxflow_solve_edmonds_karp, maxflow_solve_edmonds_karp_DMOD};
+	std::vector<std::function<void(Flowgraph<Edge::Minflow>&)>> mifsol = {lemon_cs<int>, lemon_cs_minlen<int>, lemon_ns<int>, lemon_ns_minlen<int>, lemon_cc<int>, lemon_cc_minlen<int>, lemon_caps<int>, lemon_caps_minlen<int>, naive_minflow_solve<int>};
+	std::vector<std::function<void(Flowgraph<Edge::Maxflow>&)>> mafsol = {lemon_preflow<int>, maxflow_solve_edmonds_karp<int>, maxflow_solve_edmonds_karp_DMOD<int>};
 
 	std::vector<path_cover> pc;
 	int prev_width = -1;
@@ -104,6 +134,17 @@ void test_all(Graph &g) {
 			EXPECT_TRUE(chain_cover1->size() == chain_cover2->size());
 			reach_test(g, cover); 
 		}
+		auto rg = std::make_unique<Flowgraph<Edge::Minflow>>(rgo);
+		auto net = lemon_convert(*rg);
+		for(auto alg:{lemon_mcf::network_simplex, lemon_mcf::cost_scaling, lemon_mcf::cycle_canceling, lemon_mcf::capacity_scaling}) {
+			for(bool minlen:{false, true}) {
+				lemon_minflow_solve(*net, alg, minlen);
+				Flowgraph<Edge::Minflow> fgc(*rg);
+				auto cover = minflow_reduction_path_recover_faster(fgc);
+				EXPECT_TRUE(is_valid_cover(cover, g));
+				pc.push_back(cover);
+			}
+		}
 		for(auto sol:mafsol) {
 			auto rg = std::make_unique<Flowgraph<Edge::Minflow>>(rgo);
 			minflow_maxflow_reduction(*rg, sol);
@@ -118,6 +159,8 @@ void test_all(Graph &g) {
 	test(*r2);
 	auto r4 = greedy_minflow_reduction_sparsified(g);
 	test(*r4);
+	auto r5 = greedy_minflow_reduction_incremental(g);
+	test(*r5);
 	for(int i=1; i<pc.size(); i++) {
 		ASSERT_TRUE(pc[i-1].size() == pc[i].size()) << pc[i-1].size() << " " << pc[i].size();
 	}
@@ -173,6 +216,44 @@ void random_binarytree_test_all(int seed) {
 	}
 }
 
+void edge_cover_test_all(Graph &g) {
+	auto r1 = naive_minflow_reduction_edges(g);
+	naive_minflow_solve(*r1);
+	auto c1 = minflow_reduction_path_recover_faster(*r1);
+	EXPECT_TRUE(is_valid_edge_cover(c1, g));
+	auto r2 = greedy_minflow_reduction_edges(g);
+	minflow_maxflow_reduction(*r2, maxflow_solve_edmonds_karp_DMOD<int>);
+	auto c2 = minflow_reduction_path_recover_faster(*r2);
+	EXPECT_TRUE(is_valid_edge_cover(c2, g));
+	auto r3 = pflow_edge_cover(g, pflowk2);
+	auto c3 = minflow_reduction_path_recover_faster(*r3);
+	EXPECT_TRUE(is_valid_edge_cover(c3, g));
+	auto r4 = pflow_edge_cover(g, pflowk3);
+	auto c4 = minflow_reduction_path_recover_faster(*r4);
+	EXPECT_TRUE(is_valid_edge_cover(c4, g));
+	EXPECT_TRUE(c1.size() == c2.size() && c1.size() == c3.size() && c1.size() == c4.size()) << c1.size() << " " << c2.size() << " " << c3.size() << " " << c4.size();
+}
+
+int total_length(Flowgraph<Edge::Minflow> &fg) {
+	int len = 0;
+	for(int i=1; i<=fg.n; i++)
+		for(auto &[u,e]:fg.edge_out[i])
+			len += e->demand > 0 ? e->flow : 0;
+	return len;
+}
+
+void minlen_test(Graph &g) {
+	auto r1 = full_minflow_reduction(g, *pflowk2(g));
+	minflow_minlen_solve(*r1);
+	auto r2 = naive_minflow_reduction(g);
+	lemon_ns_minlen(*r2);
+	EXPECT_EQ(total_length(*r1), total_length(*r2));
+	auto c1 = minflow_reduction_path_recover_faster(*r1);
+	auto c2 = minflow_reduction_path_recover_faster(*r2);
+	EXPECT_TRUE(is_valid_cover(c1, g));
+	EXPECT_EQ(c1.size(), c2.size());
+}
+
 class tc1 :
     public testing::TestWithParam<int> {
 };
@@ -188,6 +269,721 @@ TEST_P(tc1, random_partite_test_all) {
 TEST_P(tc1, random_chain_test_all) {
 	random_chain_test_all(GetParam());
 }
+TEST_P(tc1, edge_cover) {
+	for(int m=0; m<=1000; m+=50) {
+		auto g = random_dag(60, m, GetParam());
+		edge_cover_test_all(*g);
+	}
+	for(int k=2; k<10; k++) {
+		auto g = random_x_chain(k, 50, 100, GetParam());
+		edge_cover_test_all(*g);
+	}
+}
+
+TEST_P(tc1, minlen) {
+	for(int m=0; m<=1000; m+=50) {
+		auto g = random_dag(60, m, GetParam());
+		minlen_test(*g);
+	}
+	for(int k=2; k<10; k++) {
+		auto g = random_x_chain(k, 100, 200, GetParam());
+		minlen_test(*g);
+	}
+}
+
+// Weights summing past 2^31, the maximum weight antichain weighs as much as the minimum flow
+void weighted_antichain_test(Graph &g, int seed) {
+	std::mt19937 gen(seed);
+	std::vector<long long> weight(g.n+1);
+	for(int i=1; i<=g.n; i++)
+		weight[i] = (1LL<<32) + gen()%1000;
+	auto fg = naive_minflow_reduction<long long>(g, [&weight](int i){return weight[i];});
+	minflow_maxflow_reduction(*fg, maxflow_solve_edmonds_karp_DMOD<long long>);
+	ASSERT_TRUE(is_valid_minflow(*fg));
+	long long flow = 0;
+	for(auto &[u,e]:fg->edge_out[fg->source])
+		flow += e->flow;
+	auto ac = maxantichain_from_minflow(*fg);
+	long long ac_weight = 0;
+	for(auto u:ac)
+		ac_weight += weight[u];
+	ASSERT_TRUE(is_antichain(ac, g));
+	ASSERT_EQ(flow, ac_weight);
+}
+
+// Weighted greedy reductions are valid and every weighted solver reaches the same minimum flow
+void weighted_minflow_test(Graph &g, int seed) {
+	std::mt19937 gen(seed);
+	std::vector<int> weight(g.n+1);
+	for(int i=1; i<=g.n; i++)
+		weight[i] = gen()%5;
+	auto w = [&weight](int i){return weight[i];};
+	auto flow_value = [](Flowgraph<Edge::Minflow> &fg) {
+		int flow = 0;
+		for(auto &[u,e]:fg.edge_out[fg.source])
+			flow += e->flow;
+		return flow;
+	};
+	auto r1 = naive_minflow_reduction<int>(g, w);
+	lemon_ns(*r1);
+	auto r2 = greedy_minflow_reduction<int>(g, w);
+	auto r3 = greedy_minflow_reduction_sparsified<int>(g, w);
+	auto r5 = greedy_minflow_reduction_incremental<int>(g, 1, w);
+	ASSERT_TRUE(is_valid_minflow(*r2) && is_valid_minflow(*r3) && is_valid_minflow(*r5));
+	minflow_maxflow_reduction(*r2, maxflow_solve_edmonds_karp_DMOD<int>);
+	minflow_maxflow_reduction(*r3, maxflow_solve_edmonds_karp_DMOD<int>);
+	minflow_maxflow_reduction(*r5, maxflow_solve_edmonds_karp_DMOD<int>);
+	auto r4 = pflowk2_weighted<int>(g, w);
+	ASSERT_TRUE(is_valid_minflow(*r4));
+	int flow = flow_value(*r1);
+	ASSERT_EQ(flow, flow_value(*r2));
+	ASSERT_EQ(flow, flow_value(*r3));
+	ASSERT_EQ(flow, flow_value(*r5));
+	ASSERT_EQ(flow, flow_value(*r4));
+	auto ac = maxantichain_from_minflow(*r4);
+	int ac_weight = 0;
+	for(auto u:ac)
+		ac_weight += weight[u];
+	ASSERT_TRUE(is_antichain(ac, g));
+	ASSERT_EQ(flow, ac_weight);
+}
+
+// Threads only split the levels, the incremental greedy flow does not depend on them
+TEST_P(tc1, greedy_incremental) {
+	auto g = random_dag(20000, 30000, GetParam());
+	auto r1 = greedy_minflow_reduction_incremental(*g);
+	auto r2 = greedy_minflow_reduction_incremental(*g, 3);
+	ASSERT_TRUE(is_valid_minflow(*r1));
+	for(int i=1; i<=r1->n; i++)
+		for(int j=0; j<r1->edge_out[i].size(); j++)
+			ASSERT_EQ(r1->edge_out[i][j].second->flow, r2->edge_out[i][j].second->flow);
+}
+
+TEST_P(tc1, weighted_antichain) {
+	for(int m=0; m<=1000; m+=100) {
+		auto g = random_dag(100, m, GetParam());
+		weighted_antichain_test(*g, GetParam());
+		weighted_minflow_test(*g, GetParam());
+	}
+	for(int k=2; k<10; k++) {
+		auto g = random_x_chain(k, 100, 200, GetParam());
+		weighted_antichain_test(*g, GetParam());
+		weighted_minflow_test(*g, GetParam());
+	}
+}
+
+// Scratch state is reused across vertices, pflowk2 allocates about as much as a copy of its output
+TEST_P(tc1, pflow_allocations) {
+	for(int n:{1000, 10000}) {
+		auto g = random_x_chain(GetParam(), n, 3*n, GetParam());
+		auto before = allocation_count();
+		auto fg = pflowk2(*g);
+		auto solver = allocation_count()-before;
+		before = allocation_count();
+		Flowgraph<Edge::Minflow> copy(*fg);
+		auto output = allocation_count()-before;
+		ASSERT_LT(solver, output+1000) << n;
+	}
+}
+
+// Switching at every point of the sweep keeps the width of pflowk2
+TEST_P(tc1, pflowk2_adaptive) {
+	for(int k:{1, 5, 20}) {
+		auto g = random_x_chain(k, 200, 800, GetParam());
+		auto c = minflow_reduction_path_recover_faster(*pflowk2(*g));
+		for(int w=0; w<=k; w++) {
+			int fallback_at;
+			auto fg = pflowk2_adaptive(*g, w, &fallback_at);
+			ASSERT_TRUE(is_valid_minflow(*fg));
+			auto c1 = minflow_reduction_path_recover_faster(*fg);
+			EXPECT_TRUE(is_valid_cover(c1, *g));
+			EXPECT_EQ(c1.size(), c.size()) << k << " " << w;
+			if(w >= (int) c.size()) {
+				EXPECT_EQ(fallback_at, -1);
+			}
+		}
+	}
+}
+
+// Vertices appended in a topological order, every prefix checked against pflowk2, some after a cancelled add
+TEST_P(tc1, online_mpc) {
+	auto g = random_x_chain(GetParam(), 200, 800, GetParam());
+	std::vector<int> order, indeg(g->n+1), id(g->n+1);
+	for(int i=1; i<=g->n; i++)
+		if((indeg[i] = g->edge_in[i].size()) == 0)
+			order.push_back(i);
+	for(int i=0; i<order.size(); i++)
+		for(auto u:g->edge_out[order[i]])
+			if(--indeg[u] == 0)
+				order.push_back(u);
+	online_mpc mpc;
+	Graph prefix(g->n);
+	for(int i=0; i<order.size(); i++) {
+		std::vector<int> in;
+		for(auto u:g->edge_in[order[i]])
+			in.push_back(id[u]);
+		if(i%7 == 3) { // a cancelled add leaves the state as it was
+			cancel_token cancelled;
+			cancelled.cancel();
+			cancel_scope scope(&cancelled);
+			EXPECT_THROW(mpc.add_vertex(in), solver_cancelled);
+			ASSERT_EQ(mpc.size(), i);
+		}
+		id[order[i]] = mpc.add_vertex(in);
+		ASSERT_EQ(id[order[i]], i+1);
+		for(auto u:in)
+			prefix.add_edge(u, i+1);
+		prefix.n = i+1;
+		if(i%20 && i+1 < order.size())
+			continue;
+		auto c = minflow_reduction_path_recover_faster(*pflowk2(prefix));
+		ASSERT_EQ(mpc.width(), c.size()) << i;
+		auto c1 = mpc.current_cover();
+		EXPECT_EQ(c1.size(), c.size());
+		EXPECT_TRUE(is_valid_cover(c1, prefix));
+		auto ac = mpc.current_antichain();
+		EXPECT_EQ(ac.size(), c.size());
+		EXPECT_TRUE(is_antichain(ac, prefix));
+	}
+}
+
+TEST_P(tc1, sliding_window) {
+	auto g = random_x_chain(GetParam(), 300, 1200, GetParam());
+	std::vector<int> order, indeg(g->n+1), id(g->n+1);
+	for(int i=1; i<=g->n; i++)
+		if((indeg[i] = g->edge_in[i].size()) == 0)
+			order.push_back(i);
+	for(int i=0; i<order.size(); i++)
+		for(auto u:g->edge_out[order[i]])
+			if(--indeg[u] == 0)
+				order.push_back(u);
+	for(int W:{1, 17, 60}) {
+		sliding_window_mpc mpc(W);
+		std::vector<std::vector<int>> in(g->n+1);
+		for(int i=0; i<order.size(); i++) {
+			for(auto u:g->edge_in[order[i]])
+				in[i+1].push_back(id[u]);
+			id[order[i]] = mpc.add_vertex(in[i+1]);
+			ASSERT_EQ(id[order[i]], i+1);
+			if(i%7)
+				continue;
+			// The window renumbered from 1
+			int f = mpc.first();
+			ASSERT_EQ(f, std::max(1, i+2-W));
+			Graph window(i+2-f);
+			for(int v=f; v<=i+1; v++)
+				for(auto u:in[v])
+					if(u >= f)
+						window.add_edge(u-f+1, v-f+1);
+			auto c = minflow_reduction_path_recover_faster(*pflowk2(window));
+			ASSERT_EQ(mpc.width(), c.size()) << W << " " << i;
+			auto c1 = mpc.current_cover();
+			for(auto &p:c1)
+				for(auto &u:p)
+					u -= f-1;
+			EXPECT_EQ(c1.size(), c.size());
+			EXPECT_TRUE(is_valid_cover(c1, window));
+			auto ac = mpc.current_antichain();
+			for(auto &u:ac)
+				u -= f-1;
+			EXPECT_EQ(ac.size(), c.size());
+			EXPECT_TRUE(is_antichain(ac, window));
+		}
+		EXPECT_EQ(mpc.insert_latency.updates, g->n);
+		EXPECT_EQ(mpc.expire_latency.updates, std::max(0, g->n-W));
+	}
+}
+
+// Disjoint random DAGs with shuffled ids and some isolated vertices
+TEST_P(tc1, components) {
+	std::mt19937 rng(GetParam());
+	std::vector<std::unique_ptr<Graph>> dags;
+	int n = 20;
+	for(int c=0; c<12; c++) {
+		int sz = c%4 == 0 ? 150 : 2+c;
+		dags.push_back(random_dag(sz, sz*(sz-1)/4, GetParam()+c));
+		n += sz;
+	}
+	std::vector<int> perm(n);
+	std::iota(perm.begin(), perm.end(), 1);
+	std::shuffle(perm.begin(), perm.end(), rng);
+	Graph g(n);
+	int base = 20;
+	for(auto &d:dags) {
+		for(int v=1; v<=d->n; v++)
+			for(auto u:d->edge_out[v])
+				g.add_edge(perm[base+v-1], perm[base+u-1]);
+		base += d->n;
+	}
+	int width = minflow_reduction_path_recover_faster(*pflowk2(g)).size();
+	for(int batch:{1, 40, 100000}) {
+		auto cp = split_components(g, batch);
+		int vertices = 0;
+		for(auto &ids:cp.ids)
+			vertices += ids.size();
+		EXPECT_EQ(vertices, n);
+		if(batch == 1) {
+			EXPECT_EQ(cp.parts.size(), cp.components);
+		}
+		for(minflow_solver solver:{minflow_solver(pflowk2), minflow_solver([](Graph &g){
+			auto fg = greedy_minflow_reduction(g);
+			minflow_maxflow_reduction(*fg, maxflow_solve_edmonds_karp_DMOD<int>);
+			return fg;
+		})}) {
+			int parts = 0;
+			auto fg = components_minflow(g, solver, 3, batch, &parts);
+			EXPECT_EQ(parts, cp.parts.size());
+			EXPECT_TRUE(is_valid_minflow(*fg));
+			auto c = components_cover(g, solver, 3, batch);
+			EXPECT_TRUE(is_valid_cover(c, g));
+			auto ac = components_antichain(g, solver, 3, batch);
+			EXPECT_TRUE(is_antichain(ac, g));
+			EXPECT_EQ(minflow_reduction_path_recover_faster(*fg).size(), width);
+			EXPECT_EQ(c.size(), width);
+			EXPECT_EQ(ac.size(), width);
+		}
+	}
+}
+
+TEST_P(tc1, segments) {
+	for(int k:{1, 4, 20}) {
+		auto g = random_x_chain(k, 400, 1500, GetParam());
+		int width = minflow_reduction_path_recover_faster(*pflowk2(*g)).size();
+		for(int segments:{1, 2, 5, 37, 400}) {
+			segment_times times;
+			auto fg = segments_minflow(*g, pflowk2, segments, 3, &times);
+			EXPECT_TRUE(is_valid_minflow(*fg));
+			EXPECT_EQ(times.segment.size(), segments);
+			auto c = minflow_reduction_path_recover_faster(*fg);
+			EXPECT_TRUE(is_valid_cover(c, *g));
+			EXPECT_EQ(c.size(), width) << k << " " << segments;
+		}
+	}
+}
+
+// Random DAGs in series, joined by bottleneck vertices, cuts checked against counting comparable vertices
+TEST_P(tc1, series) {
+	std::mt19937 rng(GetParam());
+	for(int blocks:{1, 3, 8}) {
+		std::vector<std::pair<int,int>> edges;
+		int n = 0, last_cut = 0;
+		for(int b=0; b<blocks; b++) {
+			int sz = rng()%30;
+			auto d = random_dag(sz, sz*(sz-1)/6, GetParam()+b);
+			for(int v=1; v<=sz; v++) {
+				for(auto u:d->edge_out[v])
+					edges.push_back({n+v, n+u});
+				if(last_cut && d->edge_in[v].empty())
+					edges.push_back({last_cut, n+v});
+				if(d->edge_out[v].empty())
+					edges.push_back({n+v, n+sz+1});
+			}
+			if(last_cut && sz == 0)
+				edges.push_back({last_cut, n+1});
+			n += sz+1;
+			last_cut = b+1 < blocks ? n : 0;
+		}
+		std::vector<int> perm(n+1);
+		std::iota(perm.begin(), perm.end(), 0);
+		std::shuffle(perm.begin()+1, perm.end(), rng);
+		Graph g(n);
+		for(auto [a,b]:edges)
+			g.add_edge(perm[a], perm[b]);
+		auto cuts = series_cuts(g);
+		std::vector<bool> is_cut(n+1);
+		for(auto v:cuts)
+			is_cut[v] = true;
+		for(int v=1; v<=n; v++) {
+			std::vector<bool> seen(n+1);
+			int comparable = 0;
+			for(auto adj:{&g.edge_out, &g.edge_in}) {
+				std::vector<int> q = {v};
+				for(int h=0; h<q.size(); h++)
+					for(auto u:(*adj)[q[h]])
+						if(!seen[u]) {
+							seen[u] = true;
+							comparable++;
+							q.push_back(u);
+						}
+			}
+			EXPECT_EQ(is_cut[v], comparable == n-1) << v;
+		}
+		int width = minflow_reduction_path_recover_faster(*pflowk2(g)).size();
+		int pieces = 0;
+		auto c = series_cover(g, pflowk2, 3, &pieces);
+		EXPECT_EQ(pieces, cuts.size()+1);
+		EXPECT_TRUE(is_valid_cover(c, g));
+		EXPECT_EQ(c.size(), width);
+	}
+	Graph empty(0);
+	EXPECT_TRUE(series_cover(empty, pflowk2, 1).empty());
+}
+
+// The first solver to finish wins, one that only stops once cancelled is reported at the time of the winner. Solvers
+// that throw drop out, if all of them do the exception reaches the caller
+TEST_P(tc1, portfolio) {
+	auto g = random_x_chain(8, 2000, 5000, GetParam());
+	int width = minflow_reduction_path_recover_faster(*pflowk2(*g)).size();
+	auto waiting = [](Graph &)->std::unique_ptr<Flowgraph<Edge::Minflow>> {
+		while(true) {
+			cancel_point_now();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	};
+	auto failing = [](Graph &)->std::unique_ptr<Flowgraph<Edge::Minflow>> {
+		throw std::bad_alloc();
+	};
+	std::vector<std::pair<minflow_solver, std::string>> solvers = {
+		{waiting, "slow"},
+		{pflowk2, "pflowk2"},
+		{failing, "failing"}};
+	portfolio_result result;
+	auto fg = portfolio_minflow(*g, solvers, &result);
+	ASSERT_TRUE(is_valid_minflow(*fg));
+	EXPECT_EQ(minflow_reduction_path_recover_faster(*fg).size(), width);
+	EXPECT_EQ(result.winner, "pflowk2");
+	EXPECT_EQ(result.names, std::vector<std::string>({"slow", "pflowk2", "failing"}));
+	EXPECT_EQ(result.finished, std::vector<bool>({false, true, false}));
+	EXPECT_EQ(result.ms[0], result.ms[1]);
+	std::vector<std::pair<minflow_solver, std::string>> all_failing = {{failing, "a"}, {failing, "b"}};
+	EXPECT_THROW(portfolio_minflow(*g, all_failing), std::bad_alloc);
+}
+
+// Solvers stop at their next cancel point once the token of the thread is cancelled or past its deadline. A cancelled
+// repair keeps a valid flow and finishes later, a portfolio cancels the solvers that lost
+TEST_P(tc1, cancel) {
+	auto g = random_x_chain(16, 3000, 9000, GetParam());
+	int width = minflow_reduction_path_recover_faster(*pflowk2(*g)).size();
+	auto fg = greedy_minflow_reduction(*g);
+	cancel_token cancelled;
+	cancelled.cancel();
+	{
+		cancel_scope scope(&cancelled);
+		EXPECT_THROW(pflowk2(*g), solver_cancelled);
+		EXPECT_THROW(pflowk3(*g), solver_cancelled);
+		EXPECT_THROW(greedy_minflow_reduction(*g), solver_cancelled);
+		EXPECT_THROW(graph_reachability(*g), solver_cancelled);
+		EXPECT_THROW(components_minflow(*random_dag(3000, 2000, GetParam()), pflowk2, 2, 1), solver_cancelled);
+		Flowgraph<Edge::Minflow> copy(*fg);
+		EXPECT_THROW(minflow_maxflow_reduction(copy, maxflow_solve_edmonds_karp<int>), solver_cancelled);
+		minflow_decremental dec(*fg);
+		for(auto &[u,e]:fg->edge_out[fg->source])
+			if(e->flow > 0)
+				dec.touched.push_back(u);
+		EXPECT_THROW(dec.repair(), solver_cancelled);
+		ASSERT_TRUE(is_valid_minflow(*fg));
+		cancel_scope none(nullptr);
+		dec.repair();
+	}
+	EXPECT_EQ(minflow_reduction_path_recover_faster(*fg).size(), width);
+
+	auto big = random_dag(20000, 30000, GetParam());
+	cancel_token deadline;
+	deadline.cancel_after(20);
+	{
+		cancel_scope scope(&deadline);
+		EXPECT_THROW(pflowk2(*big), solver_cancelled);
+	}
+	auto start = std::chrono::steady_clock::now();
+	auto ms = [&start]{return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();};
+	cancel_token token;
+	std::thread canceller([&token]{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		token.cancel();
+	});
+	{
+		cancel_scope scope(&token);
+		EXPECT_THROW(pflowk3(*big), solver_cancelled);
+	}
+	canceller.join();
+	EXPECT_LT(ms(), 10000); // a full run of pflowk3 takes far longer, the margin is for loaded machines
+
+	auto stopped = std::make_shared<std::atomic<bool>>(false);
+	std::vector<std::pair<minflow_solver, std::string>> solvers = {
+		{[stopped](Graph &)->std::unique_ptr<Flowgraph<Edge::Minflow>> {
+			struct on_exit {
+				std::shared_ptr<std::atomic<bool>> stopped;
+				~on_exit() {*stopped = true;}
+			} guard = {stopped};
+			while(true)
+				cancel_point();
+		}, "endless"},
+		{pflowk2, "pflowk2"}};
+	portfolio_result result;
+	portfolio_minflow(*g, solvers, &result);
+	EXPECT_EQ(result.winner, "pflowk2");
+	for(int i=0; i<10000 && !*stopped; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	EXPECT_TRUE(*stopped);
+}
+
+// Nested parallel loops visit every index once, a task runs under the cancel token of the thread that forked it and
+// its exception is rethrown by wait. Every thread has its own scratch, large components get threads of their own
+TEST_P(tc1, pool) {
+	pool_configure(GetParam()%4+1);
+	int n = 10000*GetParam();
+	std::vector<int> hits(n);
+	parallel_for(0, 100, 7, [&hits, n](int lo, int hi) {
+		for(int b=lo; b<hi; b++)
+			parallel_for(b*n/100, (b+1)*n/100, 13, [&hits](int lo, int hi) {
+				for(int i=lo; i<hi; i++)
+					hits[i]++;
+			});
+	});
+	EXPECT_EQ(std::count(hits.begin(), hits.end(), 1), n);
+	std::mutex m;
+	std::vector<std::vector<int>*> scratches;
+	parallel_for(0, 64, 1, [&m, &scratches](int, int) {
+		auto *s = &thread_scratch<std::vector<int>>();
+		std::lock_guard<std::mutex> lock(m);
+		if(std::find(scratches.begin(), scratches.end(), s) == scratches.end())
+			scratches.push_back(s);
+	});
+	EXPECT_LE(scratches.size(), pool_threads());
+	task_group tasks;
+	tasks.run([]{throw std::runtime_error("task");});
+	tasks.run([]{});
+	EXPECT_THROW(tasks.wait(), std::runtime_error);
+	cancel_token cancelled;
+	cancelled.cancel();
+	{
+		cancel_scope scope(&cancelled);
+		EXPECT_THROW(parallel_for(0, 100, 1, [](int, int){cancel_point();}), solver_cancelled);
+	}
+	auto g = random_dag(3000, 2000, GetParam());
+	auto fg = components_minflow(*g, pflowk2, 4, 64);
+	ASSERT_TRUE(is_valid_minflow(*fg));
+	auto cover = minflow_reduction_path_recover_faster(*fg);
+	EXPECT_TRUE(is_valid_cover(cover, *g));
+	EXPECT_EQ(cover.size(), minflow_reduction_path_recover_faster(*pflowk2(*g)).size());
+	cover[0].push_back(cover[0].back());
+	EXPECT_FALSE(is_valid_cover(cover, *g));
+	// Components too large for 64 KB stacks run on threads of their own
+	pool_configure(GetParam()%4+1, 1<<16);
+	fg = components_minflow(*g, pflowk2, 4, 64);
+	ASSERT_TRUE(is_valid_minflow(*fg));
+	EXPECT_EQ(minflow_reduction_path_recover_faster(*fg).size(), cover.size());
+	pool_configure(0);
+}
+
+// Features bound the width from below and pick the rows of the rule table they were calibrated on
+TEST_P(tc1, select) {
+	auto t = binary_tree(10, GetParam()%2);
+	auto f = compute_features(*t);
+	EXPECT_EQ(f.n, 1024);
+	EXPECT_EQ(f.m, 1023);
+	EXPECT_EQ(f.depth, 11);
+	EXPECT_EQ(f.largest_level, 512);
+	EXPECT_EQ(f.tree_likeness, 1);
+	if(f.max_out <= 1) {
+		EXPECT_EQ(choose_solver(f).rule, "in_forest");
+		EXPECT_TRUE(choose_solver(f).contract_graph);
+	} else {
+		EXPECT_EQ(choose_solver(f).rule, "tree");
+	}
+	auto g = random_x_chain(8, 2000, 6000, GetParam());
+	f = compute_features(*g);
+	int width = minflow_reduction_path_recover_faster(*pflowk2(*g)).size();
+	EXPECT_LE(f.largest_level, width);
+	EXPECT_EQ(choose_solver(f).rule, "default");
+	g = random_dag(2000, 3000, GetParam());
+	f = compute_features(*g);
+	EXPECT_EQ(choose_solver(f).rule, "wide_sparse");
+	EXPECT_GT(choose_solver(f).multilevel, 0);
+}
+
+// Coarsened and repaired level by level, the multilevel flow is minimum with and without matched pairs
+TEST_P(tc1, multilevel) {
+	std::vector<std::unique_ptr<Graph>> gs;
+	gs.push_back(random_dag(2000, 2500, GetParam()));
+	gs.push_back(random_dag(2000, 6000, GetParam()));
+	gs.push_back(random_x_chain(8, 2000, 5000, GetParam()));
+	for(auto &g:gs) {
+		int width = minflow_reduction_path_recover_faster(*pflowk2(*g)).size();
+		for(bool pairs:{false, true}) {
+			multilevel_stats stats;
+			auto fg = multilevel_minflow(*g, pflowk2, 50, pairs, &stats);
+			ASSERT_TRUE(is_valid_minflow(*fg));
+			auto cover = minflow_reduction_path_recover_faster(*fg);
+			EXPECT_TRUE(is_valid_cover(cover, *g));
+			EXPECT_EQ(cover.size(), width);
+			EXPECT_EQ(stats.width[0], width);
+			for(int l=1; l<stats.n.size(); l++)
+				EXPECT_LT(stats.n[l], stats.n[l-1]);
+		}
+	}
+}
+
+// Published widths never grow, without a deadline the last one is optimal, with none left the flow is still valid
+TEST_P(tc1, anytime) {
+	auto g = random_x_chain(20, 3000, 6000, GetParam());
+	int width = minflow_reduction_path_recover_faster(*pflowk2(*g)).size();
+	std::vector<anytime_progress> published;
+	auto publish = [&published](anytime_progress &p, Flowgraph<Edge::Minflow> &fg){published.push_back(p);};
+	antichain ac;
+	auto fg = anytime_minflow(*g, 1e9, publish, 0, &ac);
+	ASSERT_TRUE(is_valid_minflow(*fg));
+	EXPECT_EQ(minflow_reduction_path_recover_faster(*fg).size(), width);
+	EXPECT_TRUE(is_antichain(ac, *g));
+	EXPECT_EQ(ac.size(), width);
+	EXPECT_TRUE(published.back().optimal);
+	EXPECT_EQ(published.back().width, width);
+	for(int i=1; i<published.size(); i++) {
+		EXPECT_LE(published[i].width, published[i-1].width);
+		EXPECT_GE(published[i].antichain, published[i-1].antichain);
+	}
+	published.clear();
+	fg = anytime_minflow(*g, 0, publish, 0, &ac);
+	ASSERT_TRUE(is_valid_minflow(*fg));
+	auto cover = minflow_reduction_path_recover_faster(*fg);
+	EXPECT_TRUE(is_valid_cover(cover, *g));
+	EXPECT_EQ(cover.size(), published.back().width);
+	EXPECT_TRUE(is_antichain(ac, *g));
+	EXPECT_EQ(ac.size(), published.back().antichain);
+	EXPECT_LE(ac.size(), width);
+	// Decomposing the published flows after the deadline does not cancel them
+	int decomposed = 0;
+	auto decompose = [&decomposed, &g](anytime_progress &p, Flowgraph<Edge::Minflow> &fg) {
+		Flowgraph<Edge::Minflow> copy(fg);
+		auto c = minflow_reduction_path_recover_faster(copy);
+		EXPECT_TRUE(is_valid_cover(c, *g));
+		EXPECT_EQ(c.size(), p.width);
+		decomposed++;
+	};
+	for(double budget:{0.0, 5.0}) {
+		decomposed = 0;
+		EXPECT_NO_THROW(fg = anytime_minflow(*g, budget, decompose, 0));
+		EXPECT_GE(decomposed, 1);
+	}
+}
+
+// Deletions on a solved reduction, repaired flow checked against solving the remaining graph
+TEST_P(tc1, decremental) {
+	std::mt19937 rng(GetParam());
+	for(int m:{100, 400, 1500}) {
+		auto g = random_dag(100, m, GetParam());
+		auto fg = greedy_minflow_reduction(*g);
+		minflow_maxflow_reduction(*fg, maxflow_solve_edmonds_karp_DMOD<int>);
+		minflow_decremental dec(*fg);
+		std::vector<bool> gone(g->n+1);
+		int deleted = 0;
+		for(int step=1; step<=60; step++) {
+			int v = rng()%g->n+1;
+			if(step%10 == 0 && !gone[v]) {
+				gone[v] = true;
+				while(!g->edge_in[v].empty())
+					g->delete_edge(g->edge_in[v].back(), v);
+				while(!g->edge_out[v].empty())
+					g->delete_edge(v, g->edge_out[v].back());
+				dec.delete_vertex(v);
+				deleted++;
+			} else if(!g->edge_out[v].empty()) {
+				int u = g->edge_out[v][rng()%g->edge_out[v].size()];
+				g->delete_edge(v, u);
+				dec.delete_edge(v, u);
+			}
+			if(step%3)
+				continue;
+			dec.repair();
+			ASSERT_TRUE(is_valid_minflow(*fg));
+			int width = 0;
+			for(auto &[u,e]:fg->edge_out[fg->source])
+				width += e->flow;
+			auto c = minflow_reduction_path_recover_faster(*pflowk2(*g));
+			ASSERT_EQ(width+deleted, c.size()) << m << " " << step;
+		}
+	}
+}
+
+// Cover of the graph before adding and deleting edges as the initial flow, the added edges let max flow shrink it
+TEST_P(tc1, initial_cover) {
+	std::mt19937 rng(GetParam());
+	for(int k:{3, 10, 30}) {
+		auto g = random_x_chain(k, 300, 1200, GetParam());
+		auto pc = minflow_reduction_path_recover_faster(*pflowk2(*g));
+		auto topo = topological_order(*g, topo_order::dfs);
+		std::vector<int> pos(g->n+1);
+		for(int i=0; i<g->n; i++)
+			pos[topo[i]] = i;
+		for(int i=0; i<30; i++) {
+			int a = rng()%g->n+1;
+			if(!g->edge_out[a].empty())
+				g->delete_edge(a, g->edge_out[a][0]);
+			int b = rng()%g->n+1, c = rng()%g->n+1;
+			if(pos[b] > pos[c])
+				std::swap(b, c);
+			if(b != c && !g->has_edge(b, c))
+				g->add_edge(b, c);
+		}
+		auto fg = cover_minflow_reduction(*g, pc);
+		ASSERT_TRUE(is_valid_minflow(*fg));
+		minflow_maxflow_reduction(*fg, maxflow_solve_edmonds_karp_DMOD<int>);
+		auto c1 = minflow_reduction_path_recover_faster(*fg);
+		auto c2 = minflow_reduction_path_recover_faster(*pflowk2(*g));
+		EXPECT_TRUE(is_valid_cover(c1, *g));
+		EXPECT_EQ(c1.size(), c2.size());
+		// the cover of the graph itself is already minimum
+		auto fg2 = cover_minflow_reduction(*g, c2);
+		EXPECT_EQ(minflow_reduction_path_recover_faster(*fg2).size(), c2.size());
+	}
+}
+
+TEST_P(tc1, pflowk2_cover) {
+	for(int m=0; m<=(100*99/2); m+=(m < 500 ? 40 : 400)) {
+		auto g = random_dag(100, m, GetParam());
+		auto c1 = pflowk2_cover(*g);
+		auto c2 = minflow_reduction_path_recover_faster(*pflowk2(*g));
+		EXPECT_TRUE(is_valid_cover(c1, *g));
+		EXPECT_EQ(c1.size(), c2.size());
+	}
+	for(int k=1; k<30; k+=4) {
+		auto g = random_x_chain(k, 500, 2000, GetParam());
+		auto c1 = pflowk2_cover(*g);
+		EXPECT_TRUE(is_valid_cover(c1, *g));
+		EXPECT_EQ(c1.size(), minflow_reduction_path_recover_faster(*pflowk2(*g)).size());
+	}
+}
+
+// Widths on both sides of the 64 path limit of the bitmask
+TEST_P(tc1, pflowk3_bitset) {
+	for(int k:{1, 7, 63, 64, 65, 100}) {
+		auto g = random_x_chain(k, 300, 1000, GetParam());
+		auto c1 = minflow_reduction_path_recover_faster(*pflowk3_bitset(*g));
+		auto c2 = minflow_reduction_path_recover_faster(*pflowk2(*g));
+		EXPECT_TRUE(is_valid_cover(c1, *g));
+		EXPECT_EQ(c1.size(), c2.size()) << k;
+	}
+}
+
+TEST_P(tc1, topo_order) {
+	for(int k:{1, 5, 30}) {
+		auto g = random_x_chain(k, 300, 1000, GetParam());
+		auto w = minflow_reduction_path_recover_faster(*pflowk2(*g)).size();
+		for(auto &[order, name]:topo_orders) {
+			auto topo = topological_order(*g, order);
+			std::vector<int> idx(g->n+1, -1);
+			for(int i=0; i<topo.size(); i++)
+				idx[topo[i]] = i;
+			for(int v=1; v<=g->n; v++)
+				for(auto u:g->edge_out[v])
+					if(order == topo_order::reverse) {
+						EXPECT_GT(idx[v], idx[u]) << name;
+					} else {
+						EXPECT_LT(idx[v], idx[u]) << name;
+					}
+			for(auto solver:{pflowk2_ordered, pflowk3_ordered}) {
+				pflow_stats stats;
+				auto fg = solver(*g, order, &stats);
+				EXPECT_TRUE(is_valid_minflow(*fg)) << name;
+				auto c = minflow_reduction_path_recover_faster(*fg);
+				EXPECT_TRUE(is_valid_cover(c, *g)) << name;
+				EXPECT_EQ(c.size(), w) << name;
+				EXPECT_GE(stats.visited, g->n) << name;
+				EXPECT_GE(stats.max_layers, 2) << name;
+			}
+		}
+	}
+}
 
 TEST_P(tc1, dfs_sparsify) {
 	for(int i=1; i<=8; i++) {
@@ -202,6 +998,16 @@ TEST_P(tc1, dfs_sparsify) {
 		test_dfs_sparsify(*g);
 	}
 }
+TEST_P(tc1, cover_sparsify) {
+	for(int m=0; m<=(100*99/2); m+=(m < 500 ? 40 : 400)) {
+		auto g = random_dag(100, m, GetParam());
+		test_cover_sparsify(*g);
+	}
+	for(int k=2; k<10; k++) {
+		auto g = random_x_chain(k, 100, 1000, GetParam());
+		test_cover_sparsify(*g);
+	}
+}
 INSTANTIATE_TEST_SUITE_P(tc, tc1, ::testing::Range(1, 10));
 
 class tc2 :